@@ -1,41 +1,22 @@
 #include "a_star.h"
+#include "trace.h"
+#include "util.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
 #include <limits.h>
+#include <math.h>
 
 
 
-typedef struct PathMetric {
-    uint16_t intersections;
-    uint16_t length;
-} PathMetric;
-
 #define PQ_KEY_TYPE PathMetric
 #define PQ_VAL_TYPE Uint16Point
 #include "pqueue.h"
 
 
 
-// comparison function for the priority queue used in the path search
-static bool cheaper_path(const PathMetric a, const PathMetric b)
-{
-    // This comparison can be efficiently implemented by interpreting the tuple as an unsigned integer,
-    // wherein the cost occupies the most significant bits and the distance occupies the least significant bits.
-    // When implementing, this version ran faster on my machine than a straightforward lexicographic comparison,
-    // but this may depend on architecture, compiler, optimization, etc.
-    uint32_t metric_a = a.length | ((uint32_t)a.intersections << (sizeof(a.length) * CHAR_BIT));
-    uint32_t metric_b = b.length | ((uint32_t)b.intersections << (sizeof(b.length) * CHAR_BIT));
-    // guaranteed to be true as long as nothing is changed, but this might catch a mistake if the types are changed
-    static_assert(sizeof(metric_a) >= sizeof(a.intersections) + sizeof(a.length),
-                  "size of metric insufficient to contain tuple of intersections and length");
-    return metric_a < metric_b;
-}
-
-
-
 // returns a 2D-array accessible by indices [x][y], with 0 <= x < width and 0 <= y <= height.
 // must be freed using free_matrix [see below].
 static void** new_matrix(const size_t width, const size_t height, const uint8_t init_byte_value, size_t sizeoftype)
@@ -114,6 +95,50 @@ void free_path_map(bool** path_map)
 
 
 
+// Write the neighbors of p given by its neighbors bitmap to neighbors and return how many there are.
+static inline int get_neighbors(const uint8_t neighbors_bitmap, const Uint16Point p, Uint16Point neighbors[4])
+{
+    int neigh_count = 0;
+    // for each direction, check if there is an edge
+    if(neighbors_bitmap & NEIGH_X_NEG) {
+        neighbors[neigh_count++] = (Uint16Point) {p.x - 1, p.y};
+    }
+    if(neighbors_bitmap & NEIGH_X_POS) {
+        neighbors[neigh_count++] = (Uint16Point) {p.x + 1, p.y};
+    }
+    if(neighbors_bitmap & NEIGH_Y_NEG) {
+        neighbors[neigh_count++] = (Uint16Point) {p.x, p.y - 1};
+    }
+    if(neighbors_bitmap & NEIGH_Y_POS) {
+        neighbors[neigh_count++] = (Uint16Point) {p.x, p.y + 1};
+    }
+    return neigh_count;
+}
+
+
+
+// queue backend of a_star [see a_star_use_indexed_queue] and the peak size of its last queue
+static bool use_indexed_queue = false;
+static size_t last_peak_queue_size = 0;
+
+void a_star_use_indexed_queue(const bool indexed)
+{
+    use_indexed_queue = indexed;
+}
+
+size_t a_star_peak_queue_size(void)
+{
+    return last_peak_queue_size;
+}
+
+// id of a node for the indexed queue, context points to the height of the graph
+static size_t node_id(const void* context, const KeyValPair pair)
+{
+    return (size_t)pair.val.x * *(const uint16_t*)context + pair.val.y;
+}
+
+
+
 // Calculate the minimal cost possible for a path between p1 and p2, where the cost of a path is
 // defined as the sum of the node costs of all the nodes in the path, including start and end.
 // Fill the predecessor table iff pred_tbl != NULL, else ignore it.
@@ -123,7 +148,10 @@ static int16_t a_star(const Graph* const g, HeuristicFunc h, Uint16Point** pred_
     const Uint16Point p1 = g->p1;
     const Uint16Point p2 = g->p2;
 
-    PQueue* openset = pq_new(cheaper_path); // path metrics are keys, node ids are values
+    // path metrics are keys, node ids are values
+    // With the indexed queue, an improved node replaces its entry, so there are no outdated entries.
+    PQueue* openset = use_indexed_queue ? pq_new_indexed(cheaper_path, (size_t)g->width * g->height, node_id, &g->height)
+                                        : pq_new(cheaper_path);
     assert(openset != NULL);
     PathMetric path_metric_p1 = {.intersections = g->node_cost[p1.x][p1.y], .length = 0};
     pq_insert(openset, (KeyValPair) {.key = path_metric_p1, .val = p1});
@@ -135,33 +163,32 @@ static int16_t a_star(const Graph* const g, HeuristicFunc h, Uint16Point** pred_
     }
 
     g_scores[p1.x][p1.y] = path_metric_p1;
+    TRACE_EVENT(TRACE_SEARCH, g->width, g->height, 0, 0, 0);
 
     while(!pq_is_empty(openset)) {
         const KeyValPair current = pq_pop(openset);
         const Uint16Point cur_point = current.val;
         const PathMetric cur_g_score = g_scores[cur_point.x][cur_point.y];
+#ifdef WA_TRACE
+        {
+            // the entry is outdated if the node has been reached more cheaply after it was inserted
+            const PathMetric estimate = h(cur_point, p2);
+            const PathMetric cur_f_score = {cur_g_score.intersections + estimate.intersections,
+                                            cur_g_score.length + estimate.length};
+            TRACE_EVENT(cheaper_path(cur_f_score, current.key) ? TRACE_STALE : TRACE_POP, cur_point.x, cur_point.y,
+                        current.key.intersections, current.key.length, pq_size(openset));
+        }
+#endif
         if(cur_point.x == p2.x && cur_point.y == p2.y) { // if current point is goal
+            TRACE_EVENT(TRACE_DONE, p2.x, p2.y, current.key.intersections, current.key.length, pq_size(openset));
+            last_peak_queue_size = pq_peak_size(openset);
             pq_free(openset);
             free_scores_table(g_scores);
             return (int16_t)current.key.intersections;
         }
 
         Uint16Point neighbors[4];
-        int neigh_count = 0;
-        const uint8_t cur_neighbors_bitmap = g->neighbors[cur_point.x][cur_point.y];
-        // for each direction, check if there is an edge
-        if(cur_neighbors_bitmap & NEIGH_X_NEG) {
-            neighbors[neigh_count++] = (Uint16Point) {cur_point.x - 1, cur_point.y};
-        }
-        if(cur_neighbors_bitmap & NEIGH_X_POS) {
-            neighbors[neigh_count++] = (Uint16Point) {cur_point.x + 1, cur_point.y};
-        }
-        if(cur_neighbors_bitmap & NEIGH_Y_NEG) {
-            neighbors[neigh_count++] = (Uint16Point) {cur_point.x, cur_point.y - 1};
-        }
-        if(cur_neighbors_bitmap & NEIGH_Y_POS) {
-            neighbors[neigh_count++] = (Uint16Point) {cur_point.x, cur_point.y + 1};
-        }
+        const int neigh_count = get_neighbors(g->neighbors[cur_point.x][cur_point.y], cur_point, neighbors);
         // for each neighbor of current
         for(int i = 0; i < neigh_count; i++) {
             const Uint16Point neighbor = neighbors[i];
@@ -171,8 +198,12 @@ static int16_t a_star(const Graph* const g, HeuristicFunc h, Uint16Point** pred_
             if(cheaper_path(tent_g_score, g_scores[neighbor.x][neighbor.y])) {
                 // if the new way to get there is cheaper than every path to this node found before
                 g_scores[neighbor.x][neighbor.y] = tent_g_score;
-                PathMetric neigh_f_score = {tent_g_score.intersections, tent_g_score.length + h(neighbor, p2)};
+                const PathMetric estimate = h(neighbor, p2);
+                PathMetric neigh_f_score = {tent_g_score.intersections + estimate.intersections,
+                                            tent_g_score.length + estimate.length};
                 pq_insert(openset, (KeyValPair) {neigh_f_score, neighbor});
+                TRACE_EVENT(TRACE_RELAX, neighbor.x, neighbor.y, neigh_f_score.intersections, neigh_f_score.length,
+                            pq_size(openset));
                 if(pred_tbl) {
                     pred_tbl[neighbor.x][neighbor.y] = (Uint16Point) {cur_point.x, cur_point.y};
                 }
@@ -180,6 +211,8 @@ static int16_t a_star(const Graph* const g, HeuristicFunc h, Uint16Point** pred_
         }
     }
     // this point is only reached if there is no connection from p1 to p2
+    TRACE_EVENT(TRACE_DONE, p2.x, p2.y, UINT16_MAX, UINT16_MAX, 0);
+    last_peak_queue_size = pq_peak_size(openset);
     pq_free(openset);
     free_scores_table(g_scores);
     return -1;
@@ -230,3 +263,770 @@ int16_t a_star_path_map(const Graph* const g, HeuristicFunc h, bool** path_map)
     free_predecessor_table(pred_tbl);
     return cost_result;
 }
+
+
+
+int16_t a_star_path(const Graph* const g, HeuristicFunc h, Uint16Point* path, size_t* path_length)
+{
+    Uint16Point** pred_tbl = new_predecessor_table(g->width, g->height, 0xFF);
+    if(!pred_tbl) {
+        fprintf(stderr, "Allocation for predecessor table failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    int16_t cost_result = a_star(g, h, pred_tbl);
+
+    // walk back from the goal (p2) like a_star_path_map, then reverse the path to start at p1
+    size_t length = 0;
+    if(cost_result >= 0) {
+        Uint16Point p = g->p2;
+        while(!(p.x == g->p1.x && p.y == g->p1.y)) {
+            path[length++] = p;
+            p = pred_tbl[p.x][p.y];
+        }
+        path[length++] = p;
+        for(size_t i = 0; i < length / 2; i++) {
+            const Uint16Point tmp = path[i];
+            path[i] = path[length - 1 - i];
+            path[length - 1 - i] = tmp;
+        }
+    }
+    *path_length = length;
+
+    free_predecessor_table(pred_tbl);
+    return cost_result;
+}
+
+
+
+
+// Dijkstra's algorithm from source to all nodes. Writes the metric of the cheapest path from source to
+// each node to dist (indexed by x * height + y), with the cost of source itself not included,
+// or infinity ({UINT16_MAX, UINT16_MAX}) if the node is not reachable.
+void shortest_path_metrics(const Graph* const g, const Uint16Point source, PathMetric* dist)
+{
+    const size_t height = g->height;
+    memset(dist, 0xFF, (size_t)g->width * height * sizeof(PathMetric));
+    PQueue* openset = pq_new(cheaper_path);
+    assert(openset != NULL);
+    dist[source.x * height + source.y] = (PathMetric) {0, 0};
+    pq_insert(openset, (KeyValPair) {.key = {0, 0}, .val = source});
+    while(!pq_is_empty(openset)) {
+        const KeyValPair current = pq_pop(openset);
+        const Uint16Point cur_point = current.val;
+        const PathMetric cur_dist = dist[cur_point.x * height + cur_point.y];
+        if(cheaper_path(cur_dist, current.key)) {
+            continue; // outdated entry, the node has already been visited with a lower metric
+        }
+        Uint16Point neighbors[4];
+        const int neigh_count = get_neighbors(g->neighbors[cur_point.x][cur_point.y], cur_point, neighbors);
+        for(int i = 0; i < neigh_count; i++) {
+            const Uint16Point neighbor = neighbors[i];
+            const PathMetric tent_dist = {cur_dist.intersections + g->node_cost[neighbor.x][neighbor.y],
+                                          cur_dist.length + 1};
+            if(cheaper_path(tent_dist, dist[neighbor.x * height + neighbor.y])) {
+                dist[neighbor.x * height + neighbor.y] = tent_dist;
+                pq_insert(openset, (KeyValPair) {tent_dist, neighbor});
+            }
+        }
+    }
+    pq_free(openset);
+}
+
+/*
+ * Compact mode
+ *
+ * The default search needs 4 bytes per node for the g_scores, another 4 bytes for the predecessor table
+ * and 2 pointer tables on top. In compact mode, the predecessor of a node is stored as the 2 bit code of
+ * the direction of the move that reached it, and the g_scores are packed into 16 bits as long as they
+ * fit. Both are stored in flat arrays indexed by x * height + y.
+ */
+
+// direction of the move from the predecessor to a node
+#define DIR_X_NEG 0
+#define DIR_X_POS 1
+#define DIR_Y_NEG 2
+#define DIR_Y_POS 3
+
+
+typedef struct CompactScores {
+    uint16_t* narrow; // packed as intersections << length_bits | length, NULL if wide is used
+    PathMetric* wide;
+    unsigned length_bits;
+    size_t count; // number of nodes
+} CompactScores;
+
+
+// number of bits needed to represent v
+static unsigned bit_width(unsigned long v)
+{
+    unsigned bits = 0;
+    while(v) {
+        bits++;
+        v >>= 1;
+    }
+    return bits;
+}
+
+
+// Allocate a scores table for g in which all scores are initialized to infinity.
+// The length of a stored score is bounded by the number of nodes - 1, so narrow scores are used iff that
+// leaves bits for the intersections. The all ones value is reserved for infinity. Scores with more
+// intersections than the remaining bits can hold are rare, and widen the table when they are stored.
+static CompactScores new_compact_scores(const Graph* const g)
+{
+    const size_t node_count = (size_t)g->width * g->height;
+    CompactScores scores = {
+        .narrow = NULL, .wide = NULL, .length_bits = bit_width(node_count - 1), .count = node_count};
+    if(scores.length_bits < 16) {
+        scores.narrow = malloc(node_count * sizeof(uint16_t));
+        if(scores.narrow) {
+            memset(scores.narrow, 0xFF, node_count * sizeof(uint16_t));
+        }
+    }
+    else {
+        scores.wide = malloc(node_count * sizeof(PathMetric));
+        if(scores.wide) {
+            memset(scores.wide, 0xFF, node_count * sizeof(PathMetric));
+        }
+    }
+    if(!scores.narrow && !scores.wide) {
+        fprintf(stderr, "Allocation for compact g_scores table failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    return scores;
+}
+
+static void free_compact_scores(CompactScores* scores)
+{
+    free(scores->narrow);
+    free(scores->wide);
+}
+
+static inline PathMetric compact_scores_get(const CompactScores* const scores, const size_t id)
+{
+    if(scores->narrow) {
+        const uint16_t packed = scores->narrow[id];
+        if(packed == UINT16_MAX) {
+            return (PathMetric) {UINT16_MAX, UINT16_MAX};
+        }
+        return (PathMetric) {(uint16_t)(packed >> scores->length_bits),
+                             (uint16_t)(packed & ((1u << scores->length_bits) - 1))};
+    }
+    return scores->wide[id];
+}
+
+// Replace the narrow scores by wide ones with the same values.
+static void widen_compact_scores(CompactScores* const scores)
+{
+    scores->wide = malloc(scores->count * sizeof(PathMetric));
+    if(!scores->wide) {
+        fprintf(stderr, "Allocation for compact g_scores table failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t id = 0; id < scores->count; id++) {
+        scores->wide[id] = compact_scores_get(scores, id);
+    }
+    free(scores->narrow);
+    scores->narrow = NULL;
+}
+
+static inline void compact_scores_set(CompactScores* const scores, const size_t id, const PathMetric m)
+{
+    // below the all ones value of the intersection bits, so that the packed value is not infinity
+    if(scores->narrow && m.intersections >= (1u << (16 - scores->length_bits)) - 1) {
+        widen_compact_scores(scores);
+    }
+    if(scores->narrow) {
+        scores->narrow[id] = (uint16_t)((m.intersections << scores->length_bits) | m.length);
+    }
+    else {
+        scores->wide[id] = m;
+    }
+}
+
+
+// read and write the 2 bit direction code of node id in a packed predecessor array
+static inline uint8_t pred_dir_get(const uint8_t* const pred_dirs, const size_t id)
+{
+    return (pred_dirs[id / 4] >> (2 * (id % 4))) & 0x3;
+}
+
+static inline void pred_dir_set(uint8_t* const pred_dirs, const size_t id, const uint8_t dir)
+{
+    const unsigned shift = 2 * (id % 4);
+    pred_dirs[id / 4] = (uint8_t)((pred_dirs[id / 4] & ~(0x3u << shift)) | ((unsigned)dir << shift));
+}
+
+
+// Same as a_star, but with the compact scores table. Fill the packed predecessor direction array
+// iff pred_dirs != NULL, else ignore it.
+static int16_t a_star_compact(const Graph* const g, HeuristicFunc h, uint8_t* pred_dirs)
+{
+    const Uint16Point p1 = g->p1;
+    const Uint16Point p2 = g->p2;
+    const size_t height = g->height;
+
+    PQueue* openset = pq_new(cheaper_path); // path metrics are keys, node ids are values
+    assert(openset != NULL);
+    PathMetric path_metric_p1 = {.intersections = g->node_cost[p1.x][p1.y], .length = 0};
+    pq_insert(openset, (KeyValPair) {.key = path_metric_p1, .val = p1});
+
+    CompactScores g_scores = new_compact_scores(g);
+    compact_scores_set(&g_scores, p1.x * height + p1.y, path_metric_p1);
+
+    while(!pq_is_empty(openset)) {
+        const KeyValPair current = pq_pop(openset);
+        const Uint16Point cur_point = current.val;
+        const PathMetric cur_g_score = compact_scores_get(&g_scores, cur_point.x * height + cur_point.y);
+        if(cur_point.x == p2.x && cur_point.y == p2.y) { // if current point is goal
+            pq_free(openset);
+            free_compact_scores(&g_scores);
+            return (int16_t)current.key.intersections;
+        }
+
+        Uint16Point neighbors[4];
+        const int neigh_count = get_neighbors(g->neighbors[cur_point.x][cur_point.y], cur_point, neighbors);
+        for(int i = 0; i < neigh_count; i++) {
+            const Uint16Point neighbor = neighbors[i];
+            const size_t neighbor_id = neighbor.x * height + neighbor.y;
+            const PathMetric tent_g_score = {cur_g_score.intersections + g->node_cost[neighbor.x][neighbor.y],
+                                             cur_g_score.length + 1};
+            if(cheaper_path(tent_g_score, compact_scores_get(&g_scores, neighbor_id))) {
+                compact_scores_set(&g_scores, neighbor_id, tent_g_score);
+                const PathMetric estimate = h(neighbor, p2);
+                PathMetric neigh_f_score = {tent_g_score.intersections + estimate.intersections,
+                                            tent_g_score.length + estimate.length};
+                pq_insert(openset, (KeyValPair) {neigh_f_score, neighbor});
+                if(pred_dirs) {
+                    uint8_t dir = neighbor.x < cur_point.x   ? DIR_X_NEG
+                                  : neighbor.x > cur_point.x ? DIR_X_POS
+                                  : neighbor.y < cur_point.y ? DIR_Y_NEG
+                                                             : DIR_Y_POS;
+                    pred_dir_set(pred_dirs, neighbor_id, dir);
+                }
+            }
+        }
+    }
+    // this point is only reached if there is no connection from p1 to p2
+    pq_free(openset);
+    free_compact_scores(&g_scores);
+    return -1;
+}
+
+
+
+int16_t a_star_cost_compact(const Graph* const g, HeuristicFunc h)
+{
+    return a_star_compact(g, h, NULL);
+}
+
+
+
+int16_t a_star_path_map_compact(const Graph* const g, HeuristicFunc h, bool** path_map)
+{
+    if(!path_map) {
+        return a_star_compact(g, h, NULL); // don't crash if caller violates contract to provide pointer
+    }
+    const size_t node_count = (size_t)g->width * g->height;
+    uint8_t* pred_dirs = calloc((node_count + 3) / 4, sizeof(uint8_t));
+    if(!pred_dirs) {
+        fprintf(stderr, "Allocation for packed predecessor array failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int16_t cost_result = a_star_compact(g, h, pred_dirs);
+
+    // reconstruct the cheapest path by walking the directions back from the goal (p2)
+    if(cost_result >= 0) {
+        uint16_t x = g->p2.x;
+        uint16_t y = g->p2.y;
+        while(!(x == g->p1.x && y == g->p1.y)) {
+            path_map[x][y] = true;
+            switch(pred_dir_get(pred_dirs, (size_t)x * g->height + y)) {
+                case DIR_X_NEG: // the move went in negative x direction, so the predecessor is at x + 1
+                    x++;
+                    break;
+                case DIR_X_POS:
+                    x--;
+                    break;
+                case DIR_Y_NEG:
+                    y++;
+                    break;
+                default: // DIR_Y_POS
+                    y--;
+                    break;
+            }
+        }
+        path_map[x][y] = true; // mark the start as well
+    }
+
+    free(pred_dirs);
+    return cost_result;
+}
+
+
+
+/*
+ * Implicit mode
+ *
+ * The search on an ImplicitGraph computes node costs and neighbors on demand, and stores the g_scores
+ * in a hash table of the visited nodes only, so the memory needed is O(m + number of visited nodes).
+ */
+
+#define SPARSE_INIT_CAPACITY 1024 // must be a power of 2
+#define SPARSE_EMPTY_KEY     UINT32_MAX
+
+
+typedef struct SparseScores {
+    uint32_t* keys; // x << 16 | y, or SPARSE_EMPTY_KEY
+    PathMetric* scores;
+    size_t capacity; // always a power of 2
+    size_t count;
+} SparseScores;
+
+
+static void sparse_scores_alloc(SparseScores* table, const size_t capacity)
+{
+    table->keys = malloc(capacity * sizeof(uint32_t));
+    table->scores = malloc(capacity * sizeof(PathMetric));
+    if(!table->keys || !table->scores) {
+        fprintf(stderr, "Allocation for sparse g_scores table failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(table->keys, 0xFF, capacity * sizeof(uint32_t));
+    table->capacity = capacity;
+    table->count = 0;
+}
+
+static void sparse_scores_free(SparseScores* table)
+{
+    free(table->keys);
+    free(table->scores);
+}
+
+static inline uint32_t sparse_key(const Uint16Point p)
+{
+    return ((uint32_t)p.x << 16) | p.y;
+}
+
+// index of the slot of key, or of the empty slot where it would have to be inserted (linear probing)
+static inline size_t sparse_slot(const SparseScores* table, const uint32_t key)
+{
+    size_t i = (key * UINT32_C(2654435761)) & (table->capacity - 1); // multiplicative hashing
+    while(table->keys[i] != key && table->keys[i] != SPARSE_EMPTY_KEY) {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    return i;
+}
+
+// g_score of p, infinity if p has not been visited yet
+static inline PathMetric sparse_scores_get(const SparseScores* table, const Uint16Point p)
+{
+    const size_t i = sparse_slot(table, sparse_key(p));
+    if(table->keys[i] == SPARSE_EMPTY_KEY) {
+        return (PathMetric) {UINT16_MAX, UINT16_MAX};
+    }
+    return table->scores[i];
+}
+
+static void sparse_scores_set(SparseScores* table, const Uint16Point p, const PathMetric score)
+{
+    if(2 * (table->count + 1) > table->capacity) { // keep the load factor <= 1/2
+        SparseScores old = *table;
+        sparse_scores_alloc(table, 2 * old.capacity);
+        for(size_t i = 0; i < old.capacity; i++) {
+            if(old.keys[i] != SPARSE_EMPTY_KEY) {
+                const size_t j = sparse_slot(table, old.keys[i]);
+                table->keys[j] = old.keys[i];
+                table->scores[j] = old.scores[i];
+                table->count++;
+            }
+        }
+        sparse_scores_free(&old);
+    }
+    const uint32_t key = sparse_key(p);
+    const size_t i = sparse_slot(table, key);
+    if(table->keys[i] == SPARSE_EMPTY_KEY) {
+        table->keys[i] = key;
+        table->count++;
+    }
+    table->scores[i] = score;
+}
+
+
+
+int16_t a_star_implicit_cost(const ImplicitGraph* const ig, HeuristicFunc h)
+{
+    const Uint16Point p1 = ig->p1;
+    const Uint16Point p2 = ig->p2;
+
+    PQueue* openset = pq_new(cheaper_path); // path metrics are keys, node ids are values
+    assert(openset != NULL);
+    PathMetric path_metric_p1 = {.intersections = implicit_node_cost(ig, p1), .length = 0};
+    pq_insert(openset, (KeyValPair) {.key = path_metric_p1, .val = p1});
+
+    SparseScores g_scores;
+    sparse_scores_alloc(&g_scores, SPARSE_INIT_CAPACITY);
+    sparse_scores_set(&g_scores, p1, path_metric_p1);
+
+    int16_t result = -1; // stays -1 if there is no connection from p1 to p2
+    while(!pq_is_empty(openset)) {
+        const KeyValPair current = pq_pop(openset);
+        const Uint16Point cur_point = current.val;
+        const PathMetric cur_g_score = sparse_scores_get(&g_scores, cur_point);
+        if(cur_point.x == p2.x && cur_point.y == p2.y) { // if current point is goal
+            result = (int16_t)current.key.intersections;
+            break;
+        }
+
+        Uint16Point neighbors[4];
+        const int neigh_count = get_neighbors(implicit_neighbors(ig, cur_point), cur_point, neighbors);
+        for(int i = 0; i < neigh_count; i++) {
+            const Uint16Point neighbor = neighbors[i];
+            const PathMetric tent_g_score = {cur_g_score.intersections + implicit_node_cost(ig, neighbor),
+                                             cur_g_score.length + 1};
+            if(cheaper_path(tent_g_score, sparse_scores_get(&g_scores, neighbor))) {
+                sparse_scores_set(&g_scores, neighbor, tent_g_score);
+                const PathMetric estimate = h(neighbor, p2);
+                PathMetric neigh_f_score = {tent_g_score.intersections + estimate.intersections,
+                                            tent_g_score.length + estimate.length};
+                pq_insert(openset, (KeyValPair) {neigh_f_score, neighbor});
+            }
+        }
+    }
+    pq_free(openset);
+    sparse_scores_free(&g_scores);
+    return result;
+}
+
+
+
+/*
+ * Anytime mode (ARA*)
+ *
+ * The search is repeated with the heuristic inflated by a decreasing factor epsilon. A search with epsilon
+ * finds a path with cost <= epsilon * minimal cost, usually much faster than the exact search. Instead of
+ * starting over, every search continues with the g_scores of the previous one: nodes whose g_score was
+ * lowered after they had been expanded in the current search are kept in an INCONS set and put back into
+ * the open set for the next one.
+ * If the intersections of the g_score of a node were lowered since it was last expanded (or it has never
+ * been expanded), the improvement has not been passed on to its neighbors yet. The first such node on a
+ * cheapest path has its minimal g_score, so the minimum of g + h over these nodes is a lower bound for the
+ * minimal cost at any time, even if the search is interrupted. Nodes whose length was improved do not
+ * count, since a shorter length never leads to fewer intersections.
+ * No step between two searches looks at the whole board: the nodes opened in a search and the INCONS set
+ * are kept in lists for rebuilding the open set, and the nodes counted by the lower bound are counted per
+ * value of g + h while expanding.
+ */
+
+#define ANYTIME_EPSILON_SHIFT   4 // epsilon is stored in fixed point with 4 fractional bits
+#define ANYTIME_EPSILON_ONE     (1u << ANYTIME_EPSILON_SHIFT)
+#define ANYTIME_INITIAL_EPSILON (3 * ANYTIME_EPSILON_ONE)
+#define ANYTIME_EPSILON_STEP    (ANYTIME_EPSILON_ONE / 2)
+#define ANYTIME_CHECK_INTERVAL  64 // check the clock every x expansions
+#define ANYTIME_LIST_INIT       64
+
+// node states
+#define ANYTIME_OPEN   1
+#define ANYTIME_CLOSED 2 // expanded in the current search
+#define ANYTIME_INCONS 4
+
+
+// g + epsilon * h, saturated to the range of PathMetric
+static inline PathMetric inflated_key(const PathMetric g_score, const PathMetric estimate, const unsigned epsilon)
+{
+    const uint32_t i = g_score.intersections + ((estimate.intersections * epsilon) >> ANYTIME_EPSILON_SHIFT);
+    const uint32_t l = g_score.length + ((estimate.length * epsilon) >> ANYTIME_EPSILON_SHIFT);
+    return (PathMetric) {(uint16_t)(i < UINT16_MAX ? i : UINT16_MAX), (uint16_t)(l < UINT16_MAX ? l : UINT16_MAX)};
+}
+
+
+typedef struct PointList {
+    Uint16Point* points;
+    size_t n;
+    size_t allocated;
+} PointList;
+
+typedef struct AnytimeState {
+    const Graph* g;
+    HeuristicFunc h;
+    PathMetric** g_scores;
+    uint8_t** node_state;
+    uint16_t** expanded_intersections; // intersections of the g_score when last expanded, UINT16_MAX if never
+    Uint16Point** pred_tbl; // NULL if the path is not needed
+    PQueue* openset;
+    PointList opened; // nodes put into the open set in the current search, each at most once
+    PointList incons; // nodes in INCONS
+    // Number of nodes with intersections not passed on yet per intersections of g + h, see anytime_lower_bound.
+    // All counts below bound_min are 0.
+    uint32_t* bound_counts;
+    size_t bound_counts_size;
+    size_t bound_nodes; // sum of bound_counts
+    uint16_t bound_min;
+    unsigned epsilon;
+    unsigned long expansions;
+} AnytimeState;
+
+
+static void point_list_push(PointList* list, const Uint16Point p)
+{
+    if(list->n == list->allocated) {
+        list->allocated = list->allocated ? 2 * list->allocated : ANYTIME_LIST_INIT;
+        list->points = realloc(list->points, list->allocated * sizeof(Uint16Point));
+        if(!list->points) {
+            fprintf(stderr, "Allocation for anytime node list failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    list->points[list->n++] = p;
+}
+
+
+// Count a node whose intersections have not been passed on to its neighbors, with g + h = bound.
+// Bounds of UINT16_MAX or more are not counted, they are beyond any cost.
+static void anytime_add_bound(AnytimeState* s, const uint32_t bound)
+{
+    if(bound >= UINT16_MAX) {
+        return;
+    }
+    if(bound >= s->bound_counts_size) {
+        size_t new_size = s->bound_counts_size ? s->bound_counts_size : ANYTIME_LIST_INIT;
+        while(new_size <= bound) {
+            new_size *= 2;
+        }
+        s->bound_counts = realloc(s->bound_counts, new_size * sizeof(uint32_t));
+        if(!s->bound_counts) {
+            fprintf(stderr, "Allocation for anytime lower bound failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(s->bound_counts + s->bound_counts_size, 0, (new_size - s->bound_counts_size) * sizeof(uint32_t));
+        s->bound_counts_size = new_size;
+    }
+    s->bound_counts[bound]++;
+    s->bound_nodes++;
+    s->bound_min = bound < s->bound_min ? (uint16_t)bound : s->bound_min;
+}
+
+static void anytime_remove_bound(AnytimeState* s, const uint32_t bound)
+{
+    if(bound >= UINT16_MAX) {
+        return;
+    }
+    assert(bound < s->bound_counts_size && s->bound_counts[bound] > 0);
+    s->bound_counts[bound]--;
+    s->bound_nodes--;
+}
+
+
+// Minimum of the intersections of g + h over all nodes whose intersections have not been passed on to
+// their neighbors yet, UINT16_MAX if there are none. The counts are kept up to date while expanding, so
+// this only has to skip the counts that have dropped to 0 since the last call.
+static uint16_t anytime_lower_bound(AnytimeState* s)
+{
+    if(s->bound_nodes == 0) {
+        return UINT16_MAX;
+    }
+    while(s->bound_counts[s->bound_min] == 0) {
+        s->bound_min++;
+    }
+    return s->bound_min;
+}
+
+
+// Put every node in OPEN or INCONS into a new open set with the keys for the current epsilon, and clear
+// the CLOSED state of the nodes expanded in the last search. The entries of the old open set are outdated,
+// since the keys depend on epsilon. Only the nodes opened in the last search are visited, every node that
+// has been expanded or is still open is among them.
+static void anytime_rebuild_openset(AnytimeState* s)
+{
+    for(size_t i = 0; i < s->opened.n; i++) {
+        const Uint16Point p = s->opened.points[i];
+        if(s->node_state[p.x][p.y] == ANYTIME_OPEN) {
+            point_list_push(&s->incons, p); // OPEN and INCONS are disjoint, so no node is added twice
+        }
+        else {
+            s->node_state[p.x][p.y] = 0;
+        }
+    }
+    s->opened.n = 0;
+    pq_free(s->openset);
+    s->openset = pq_new(cheaper_path);
+    assert(s->openset != NULL);
+    for(size_t i = 0; i < s->incons.n; i++) {
+        const Uint16Point p = s->incons.points[i];
+        s->node_state[p.x][p.y] = ANYTIME_OPEN;
+        point_list_push(&s->opened, p);
+        pq_insert(s->openset, (KeyValPair) {inflated_key(s->g_scores[p.x][p.y], s->h(p, s->g->p2), s->epsilon), p});
+    }
+    s->incons.n = 0;
+}
+
+
+// Expand nodes until no node in the open set has a smaller key than the goal.
+// Returns false if the search was interrupted because the budget was exhausted.
+static bool anytime_improve_path(AnytimeState* s, const AnytimeBudget budget, const double deadline)
+{
+    const Graph* const g = s->g;
+    const Uint16Point p2 = g->p2;
+    while(!pq_is_empty(s->openset)) {
+        const KeyValPair current = pq_peek(s->openset);
+        const Uint16Point cur_point = current.val;
+        const PathMetric cur_g_score = s->g_scores[cur_point.x][cur_point.y];
+        const PathMetric cur_estimate = s->h(cur_point, p2);
+        if(!(s->node_state[cur_point.x][cur_point.y] & ANYTIME_OPEN) ||
+           cheaper_path(inflated_key(cur_g_score, cur_estimate, s->epsilon), current.key)) {
+            pq_pop(s->openset); // outdated entry, the node has been expanded or inserted with a smaller key
+            continue;
+        }
+        if(!cheaper_path(current.key, inflated_key(s->g_scores[p2.x][p2.y], s->h(p2, p2), s->epsilon))) {
+            return true;
+        }
+        if((budget.max_expansions && s->expansions >= budget.max_expansions) ||
+           (budget.max_ms && s->expansions % ANYTIME_CHECK_INTERVAL == 0 && now_ns() >= deadline)) {
+            return false;
+        }
+        pq_pop(s->openset);
+        s->node_state[cur_point.x][cur_point.y] = ANYTIME_CLOSED;
+        if(cur_g_score.intersections < s->expanded_intersections[cur_point.x][cur_point.y]) {
+            anytime_remove_bound(s, (uint32_t)cur_g_score.intersections + cur_estimate.intersections);
+        }
+        s->expanded_intersections[cur_point.x][cur_point.y] = cur_g_score.intersections;
+        s->expansions++;
+
+        Uint16Point neighbors[4];
+        const int neigh_count = get_neighbors(g->neighbors[cur_point.x][cur_point.y], cur_point, neighbors);
+        for(int i = 0; i < neigh_count; i++) {
+            const Uint16Point neighbor = neighbors[i];
+            const PathMetric tent_g_score = {cur_g_score.intersections + g->node_cost[neighbor.x][neighbor.y],
+                                             cur_g_score.length + 1};
+            const PathMetric old_g_score = s->g_scores[neighbor.x][neighbor.y];
+            if(cheaper_path(tent_g_score, old_g_score)) {
+                s->g_scores[neighbor.x][neighbor.y] = tent_g_score;
+                if(s->pred_tbl) {
+                    s->pred_tbl[neighbor.x][neighbor.y] = cur_point;
+                }
+                const PathMetric estimate = s->h(neighbor, p2);
+                if(tent_g_score.intersections < old_g_score.intersections) { // g <= expanded_intersections
+                    if(old_g_score.intersections < s->expanded_intersections[neighbor.x][neighbor.y]) {
+                        anytime_remove_bound(s, (uint32_t)old_g_score.intersections + estimate.intersections);
+                    }
+                    anytime_add_bound(s, (uint32_t)tent_g_score.intersections + estimate.intersections);
+                }
+                uint8_t* state = &s->node_state[neighbor.x][neighbor.y];
+                if(*state & ANYTIME_CLOSED) { // expanded before in this search, defer to the next one
+                    if(!(*state & ANYTIME_INCONS)) {
+                        *state |= ANYTIME_INCONS;
+                        point_list_push(&s->incons, neighbor);
+                    }
+                }
+                else {
+                    if(*state != ANYTIME_OPEN) {
+                        *state = ANYTIME_OPEN;
+                        point_list_push(&s->opened, neighbor);
+                    }
+                    pq_insert(s->openset, (KeyValPair) {inflated_key(tent_g_score, estimate, s->epsilon), neighbor});
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+
+AnytimeResult a_star_anytime(const Graph* const g, HeuristicFunc h, const AnytimeBudget budget, bool** path_map)
+{
+    const double deadline = now_ns() + (double)budget.max_ms * 1e6;
+    const Uint16Point p1 = g->p1;
+    const Uint16Point p2 = g->p2;
+
+    AnytimeState s = {.g = g,
+                      .h = h,
+                      .opened = {NULL, 0, 0},
+                      .incons = {NULL, 0, 0},
+                      .bound_counts = NULL,
+                      .bound_counts_size = 0,
+                      .bound_nodes = 0,
+                      .bound_min = UINT16_MAX,
+                      .epsilon = ANYTIME_INITIAL_EPSILON,
+                      .expansions = 0};
+    s.g_scores = new_scores_table(g->width, g->height, 0xFF);
+    s.node_state = (uint8_t**)new_matrix(g->width, g->height, 0, sizeof(uint8_t));
+    s.expanded_intersections = (uint16_t**)new_matrix(g->width, g->height, 0xFF, sizeof(uint16_t));
+    s.pred_tbl = path_map ? new_predecessor_table(g->width, g->height, 0xFF) : NULL;
+    if(!s.g_scores || !s.node_state || !s.expanded_intersections || (path_map && !s.pred_tbl)) {
+        fprintf(stderr, "Allocation for anytime search state failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    s.g_scores[p1.x][p1.y] = (PathMetric) {.intersections = g->node_cost[p1.x][p1.y], .length = 0};
+    s.node_state[p1.x][p1.y] = ANYTIME_OPEN;
+    s.openset = pq_new(cheaper_path);
+    assert(s.openset != NULL);
+    pq_insert(s.openset, (KeyValPair) {inflated_key(s.g_scores[p1.x][p1.y], h(p1, p2), s.epsilon), p1});
+    point_list_push(&s.opened, p1);
+    anytime_add_bound(&s, (uint32_t)s.g_scores[p1.x][p1.y].intersections + h(p1, p2).intersections);
+
+    AnytimeResult result = {.cost = -1, .lower_bound = 0, .bound = INFINITY, .iterations = 0};
+    float epsilon_bound = INFINITY; // epsilon of the last completed search
+    while(true) {
+        const bool completed = anytime_improve_path(&s, budget, deadline);
+        if(completed) {
+            result.iterations++;
+            epsilon_bound = (float)s.epsilon / ANYTIME_EPSILON_ONE;
+        }
+        const PathMetric goal_score = s.g_scores[p2.x][p2.y];
+        const bool found = goal_score.intersections != UINT16_MAX;
+        const uint16_t lower_bound = anytime_lower_bound(&s); // includes the goal, it is never expanded
+        if(lower_bound == UINT16_MAX) { // everything reachable has been searched without finding the goal
+            result.lower_bound = -1;
+            result.bound = 1.0f;
+            break;
+        }
+        result.cost = found ? (int16_t)goal_score.intersections : -1;
+        result.lower_bound = (int16_t)lower_bound;
+        if(found) {
+            const float ratio = result.lower_bound > 0 ? (float)result.cost / result.lower_bound
+                                : result.cost == 0 ? 1.0f
+                                                   : INFINITY;
+            result.bound = ratio < epsilon_bound ? ratio : epsilon_bound;
+        }
+        if(!completed || result.cost == result.lower_bound || s.epsilon == ANYTIME_EPSILON_ONE ||
+           (budget.max_ms && now_ns() >= deadline)) { // no time left for rebuilding the open set
+            break;
+        }
+        // continue with a smaller epsilon, at most the proven bound
+        unsigned next_epsilon = s.epsilon - ANYTIME_EPSILON_STEP;
+        if(result.lower_bound > 0) {
+            const unsigned ratio_epsilon = ((unsigned)result.cost << ANYTIME_EPSILON_SHIFT) / (unsigned)result.lower_bound;
+            next_epsilon = ratio_epsilon < next_epsilon ? ratio_epsilon : next_epsilon;
+        }
+        s.epsilon = next_epsilon > ANYTIME_EPSILON_ONE ? next_epsilon : ANYTIME_EPSILON_ONE;
+        anytime_rebuild_openset(&s);
+    }
+    result.expansions = s.expansions;
+
+    // reconstruct the best path found, starting from the goal (p2) and going back
+    if(path_map && result.cost >= 0) {
+        uint16_t x = p2.x;
+        uint16_t y = p2.y;
+        while(!(x == p1.x && y == p1.y)) {
+            path_map[x][y] = true;
+            const Uint16Point predecessor = s.pred_tbl[x][y];
+            x = predecessor.x;
+            y = predecessor.y;
+        }
+        path_map[x][y] = true;
+    }
+
+    pq_free(s.openset);
+    free(s.opened.points);
+    free(s.incons.points);
+    free(s.bound_counts);
+    free_scores_table(s.g_scores);
+    free_matrix((void**)s.node_state);
+    free_matrix((void**)s.expanded_intersections);
+    if(s.pred_tbl) {
+        free_predecessor_table(s.pred_tbl);
+    }
+    return result;
+}
@@ -8,10 +8,19 @@
 #include <stddef.h>
 
 #include "graph.h"
+#include "implicit_graph.h"
 
 
+// Metric of a path, compared lexicographically: fewer intersections first, then shorter length.
+typedef struct PathMetric {
+    uint16_t intersections;
+    uint16_t length;
+} PathMetric;
+
 // type definition for the type of heuristic fuctions
-typedef uint16_t (*HeuristicFunc)(const Uint16Point p, const Uint16Point goal);
+// The estimate for the path from p to goal is added to the metric of the path to p, component by
+// component. It must be a lower bound in the lexicographic order for the search to find the cheapest path.
+typedef PathMetric (*HeuristicFunc)(const Uint16Point p, const Uint16Point goal);
 
 // Calculate the minimal cost possible for a path between p1 and p2, where the cost of a path is
 // defined as the sum of the node costs of all the nodes in the path, including start and end.
@@ -19,6 +28,49 @@ int16_t a_star_cost(const Graph* const g, HeuristicFunc h);
 // same as a_star_cost, but mark the cheapest path in the path map. Caller is responsible for
 // giving an appropriate path map [also see new_path_map].
 int16_t a_star_path_map(const Graph* const g, HeuristicFunc h, bool** path_map);
+// Select the queue for all following searches of a_star_cost, a_star_path_map and a_star_path: the indexed
+// heap with decrease-key if indexed is true [see pq_new_indexed], else the binary heap (the default).
+void a_star_use_indexed_queue(const bool indexed);
+// greatest number of entries in the queue during the last search of a_star_cost, a_star_path_map or a_star_path
+size_t a_star_peak_queue_size(void);
+// same as a_star_cost, but write the nodes of the cheapest path in order from p1 to p2 to path, which must
+// have room for width * height points, and their number to path_length (0 if there is no path).
+int16_t a_star_path(const Graph* const g, HeuristicFunc h, Uint16Point* path, size_t* path_length);
+
+// Same as a_star_cost and a_star_path_map, but with a compact search state: the predecessors are stored
+// as 2 bit direction codes, and the g_scores are narrowed to 16 bits while the scores found so far fit.
+int16_t a_star_cost_compact(const Graph* const g, HeuristicFunc h);
+int16_t a_star_path_map_compact(const Graph* const g, HeuristicFunc h, bool** path_map);
+
+// Same as a_star_cost, but on an implicit graph, with the g_scores of the visited nodes in a hash table.
+int16_t a_star_implicit_cost(const ImplicitGraph* const ig, HeuristicFunc h);
+
+
+// Budget for a_star_anytime. The search stops as soon as one of the limits is reached.
+typedef struct AnytimeBudget {
+    unsigned long max_ms;         // wall-clock time of the search in milliseconds, 0 for no limit
+    unsigned long max_expansions; // number of expanded nodes, 0 for no limit
+} AnytimeBudget;
+
+typedef struct AnytimeResult {
+    int16_t cost;        // cost of the best path found, -1 if none was found
+    int16_t lower_bound; // proven lower bound for the minimal cost, -1 if it is proven that there is no path
+    float bound;         // proven suboptimality bound: cost <= bound * minimal cost. INFINITY if unknown
+    unsigned long expansions;
+    unsigned iterations; // number of completed searches with decreasing epsilon
+} AnytimeResult;
+
+// Anytime version of a_star_path_map (ARA*): search with the heuristic inflated by epsilon, starting at 3,
+// and repeat with decreasing epsilon and the reused search state until the cost is proven to be minimal
+// or the budget is exhausted. Returns the best path found so far and its bound.
+// path_map may be NULL if the path is not needed.
+AnytimeResult a_star_anytime(const Graph* const g, HeuristicFunc h, const AnytimeBudget budget, bool** path_map);
+
+
+// Calculate the metric of the cheapest path from source to every node, not including the cost of
+// source itself. dist must have room for width * height values and is indexed by x * height + y.
+// Unreachable nodes get {UINT16_MAX, UINT16_MAX}.
+void shortest_path_metrics(const Graph* const g, const Uint16Point source, PathMetric* dist);
 
 
 // Allocate and initialize a path map for the A* algorithm.
@@ -0,0 +1,217 @@
+#include "bend_search.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+
+
+
+// The scores are packed as intersections << 16 | length so they can be compared as a single integer,
+// and the queue holds packed f_scores as keys and state ids as values.
+#define PQ_KEY_TYPE uint32_t
+#define PQ_VAL_TYPE uint32_t
+#include "pqueue.h"
+
+
+
+// axis of the move that entered a state, the lowest bit of the state id
+#define AXIS_X 0
+#define AXIS_Y 1
+
+// 2 bit predecessor code of a state
+#define PRED_POSITIVE 0x1 // the move into the state went in positive direction
+#define PRED_AXIS_Y   0x2 // the predecessor state was entered in y direction
+
+#define INFINITE_SCORE UINT32_MAX
+
+
+typedef struct Move {
+    uint8_t neighbor_bit; // bit of the move in the neighbors bitmap
+    uint8_t axis;
+    bool positive;
+} Move;
+
+static const Move moves[4] = {{NEIGH_X_NEG, AXIS_X, false},
+                              {NEIGH_X_POS, AXIS_X, true},
+                              {NEIGH_Y_NEG, AXIS_Y, false},
+                              {NEIGH_Y_POS, AXIS_Y, true}};
+
+
+
+// comparison function for the priority queue, the smaller packed f_score has greater priority
+static bool smaller_score(const uint32_t a, const uint32_t b)
+{
+    return a < b;
+}
+
+static inline uint32_t pack_metric(const PathMetric m)
+{
+    return (uint32_t)m.intersections << 16 | m.length;
+}
+
+
+
+// Lower bound for the number of bends of a path from p to goal if p was entered along axis.
+// If p is neither in the row nor in the column of goal, the path has to change its axis at least once.
+// Else it has to bend iff it did not enter p along the line to goal.
+static inline uint32_t min_bends(const Uint16Point p, const Uint16Point goal, const unsigned axis)
+{
+    const bool dx = p.x != goal.x;
+    const bool dy = p.y != goal.y;
+    if(dx && dy) {
+        return 1;
+    }
+    return (dx && axis == AXIS_Y) || (dy && axis == AXIS_X);
+}
+
+
+
+// read and write the 2 bit predecessor code of state id in a packed predecessor array
+static inline uint8_t pred_code_get(const uint8_t* const pred_codes, const size_t id)
+{
+    return (pred_codes[id / 4] >> (2 * (id % 4))) & 0x3;
+}
+
+static inline void pred_code_set(uint8_t* const pred_codes, const size_t id, const uint8_t code)
+{
+    const unsigned shift = 2 * (id % 4);
+    pred_codes[id / 4] = (uint8_t)((pred_codes[id / 4] & ~(0x3u << shift)) | ((unsigned)code << shift));
+}
+
+
+
+// Search for the cheapest path from p1 to p2 including bend penalties [see bend_search_cost].
+// Fill the packed predecessor code array iff pred_codes != NULL, else ignore it, and write the id of the
+// state in which p2 was reached to goal_state.
+static int16_t bend_search(const Graph* const g, HeuristicFunc h, const uint16_t bend_penalty, uint8_t* pred_codes,
+                           size_t* goal_state)
+{
+    const Uint16Point p1 = g->p1;
+    const Uint16Point p2 = g->p2;
+    const size_t height = g->height;
+    const uint32_t packed_penalty = (uint32_t)bend_penalty << 16;
+
+    const size_t state_count = 2 * (size_t)g->width * height;
+    uint32_t* g_scores = malloc(state_count * sizeof(uint32_t));
+    if(!g_scores) {
+        fprintf(stderr, "Allocation for bend search g_scores failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(g_scores, 0xFF, state_count * sizeof(uint32_t));
+
+    PQueue* openset = pq_new(smaller_score); // packed f_scores are keys, state ids are values
+    assert(openset != NULL);
+    // the start has not been entered in any direction, so both of its states can continue without a bend
+    const uint32_t start_score = (uint32_t)g->node_cost[p1.x][p1.y] << 16;
+    const uint32_t start_estimate = pack_metric(h(p1, p2));
+    for(unsigned axis = AXIS_X; axis <= AXIS_Y; axis++) {
+        const size_t id = 2 * (p1.x * height + p1.y) + axis;
+        g_scores[id] = start_score;
+        pq_insert(openset, (KeyValPair) {start_score + start_estimate + min_bends(p1, p2, axis) * packed_penalty,
+                                         (uint32_t)id});
+    }
+
+    while(!pq_is_empty(openset)) {
+        const KeyValPair current = pq_pop(openset);
+        const size_t cur_id = current.val;
+        const unsigned cur_axis = cur_id & 1;
+        const size_t cur_node = cur_id / 2;
+        const Uint16Point cur_point = {(uint16_t)(cur_node / height), (uint16_t)(cur_node % height)};
+        const uint32_t cur_g_score = g_scores[cur_id];
+        const uint32_t other_g_score = g_scores[cur_id ^ 1];
+        if(other_g_score != INFINITE_SCORE && other_g_score + packed_penalty < cur_g_score) {
+            continue; // dominated by the other state of the node, which has been or will be expanded
+        }
+        if(cur_point.x == p2.x && cur_point.y == p2.y) { // if current point is goal
+            pq_free(openset);
+            free(g_scores);
+            *goal_state = cur_id;
+            return (int16_t)(cur_g_score >> 16);
+        }
+        const uint32_t cur_f_score =
+            cur_g_score + pack_metric(h(cur_point, p2)) + min_bends(cur_point, p2, cur_axis) * packed_penalty;
+        if(current.key > cur_f_score) {
+            continue; // outdated entry, the state has been inserted again with a lower score
+        }
+
+        const uint8_t neighbors = g->neighbors[cur_point.x][cur_point.y];
+        for(int i = 0; i < 4; i++) {
+            if(!(neighbors & moves[i].neighbor_bit)) {
+                continue;
+            }
+            const unsigned axis = moves[i].axis;
+            const int delta = moves[i].positive ? 1 : -1;
+            const Uint16Point neighbor = {(uint16_t)(cur_point.x + (axis == AXIS_X ? delta : 0)),
+                                          (uint16_t)(cur_point.y + (axis == AXIS_Y ? delta : 0))};
+            const size_t neigh_id = 2 * (neighbor.x * height + neighbor.y) + axis;
+            const uint32_t tent_g_score = cur_g_score + ((uint32_t)g->node_cost[neighbor.x][neighbor.y] << 16) + 1 +
+                                          (axis != cur_axis ? packed_penalty : 0);
+            const uint32_t neigh_other_score = g_scores[neigh_id ^ 1];
+            if(tent_g_score >= g_scores[neigh_id] ||
+               (neigh_other_score != INFINITE_SCORE && neigh_other_score + packed_penalty <= tent_g_score)) {
+                continue;
+            }
+            g_scores[neigh_id] = tent_g_score;
+            const uint32_t neigh_f_score = tent_g_score + pack_metric(h(neighbor, p2)) +
+                                           min_bends(neighbor, p2, axis) * packed_penalty;
+            pq_insert(openset, (KeyValPair) {neigh_f_score, (uint32_t)neigh_id});
+            if(pred_codes) {
+                pred_code_set(pred_codes, neigh_id,
+                              (uint8_t)((moves[i].positive ? PRED_POSITIVE : 0) | (cur_axis == AXIS_Y ? PRED_AXIS_Y : 0)));
+            }
+        }
+    }
+    // this point is only reached if there is no connection from p1 to p2
+    pq_free(openset);
+    free(g_scores);
+    return -1;
+}
+
+
+
+int16_t bend_search_cost(const Graph* const g, HeuristicFunc h, const uint16_t bend_penalty)
+{
+    size_t goal_state;
+    return bend_search(g, h, bend_penalty, NULL, &goal_state);
+}
+
+
+
+int16_t bend_search_path_map(const Graph* const g, HeuristicFunc h, const uint16_t bend_penalty, bool** path_map)
+{
+    if(!path_map) {
+        return bend_search_cost(g, h, bend_penalty); // don't crash if caller violates contract to provide pointer
+    }
+    const size_t state_count = 2 * (size_t)g->width * g->height;
+    uint8_t* pred_codes = calloc((state_count + 3) / 4, sizeof(uint8_t));
+    if(!pred_codes) {
+        fprintf(stderr, "Allocation for packed predecessor array failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t state = 0;
+    const int16_t cost_result = bend_search(g, h, bend_penalty, pred_codes, &state);
+
+    // reconstruct the cheapest path by walking the predecessor codes back from the goal state
+    if(cost_result >= 0) {
+        uint16_t x = g->p2.x;
+        uint16_t y = g->p2.y;
+        while(!(x == g->p1.x && y == g->p1.y)) {
+            path_map[x][y] = true;
+            const uint8_t code = pred_code_get(pred_codes, state);
+            const int delta = (code & PRED_POSITIVE) ? -1 : 1; // the predecessor is on the other side
+            if((state & 1) == AXIS_X) {
+                x = (uint16_t)(x + delta);
+            }
+            else {
+                y = (uint16_t)(y + delta);
+            }
+            state = 2 * ((size_t)x * g->height + y) + ((code & PRED_AXIS_Y) ? AXIS_Y : AXIS_X);
+        }
+        path_map[x][y] = true; // mark the start as well
+    }
+
+    free(pred_codes);
+    return cost_result;
+}
@@ -0,0 +1,37 @@
+#ifndef _BEND_SEARCH_H
+#define _BEND_SEARCH_H
+
+
+/*
+ * Search with a bend penalty
+ *
+ * With a penalty for every bend, the cost of a move depends on the direction the node was entered in,
+ * so the search state is a node together with its incoming direction. Only the axis of that direction
+ * matters: a move along the same axis never bends, and a move back to where the path came from is never
+ * part of a cheapest path. So there are 2 states per node instead of 4, with the id x * height + y
+ * times 2 plus the axis, and their g_scores are stored next to each other. A state is not inserted if
+ * the other state of the same node is cheaper by at least the bend penalty, since every path from it can
+ * be continued from the other state for at most the penalty more. The predecessor of a state is stored
+ * as a 2 bit code. The heuristic adds the penalty for the bends that are still unavoidable.
+ */
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "graph.h"
+#include "a_star.h"
+
+
+// Calculate the minimal cost of a path between p1 and p2, where the cost is the sum of the node costs of
+// all nodes in the path (including start and end) plus bend_penalty for every bend. Among the paths with
+// minimal cost, a shortest one is found. h must be a lower bound for the sum of the node costs, it does
+// not need to know about the bends. Returns -1 if there is no path.
+int16_t bend_search_cost(const Graph* const g, HeuristicFunc h, const uint16_t bend_penalty);
+// same as bend_search_cost, but mark the cheapest path in the path map [also see new_path_map].
+int16_t bend_search_path_map(const Graph* const g, HeuristicFunc h, const uint16_t bend_penalty, bool** path_map);
+
+
+
+#endif
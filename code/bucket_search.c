@@ -0,0 +1,165 @@
+#include "bucket_search.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+
+
+// Node costs are at most UINT8_MAX, so a node is never inserted more than UINT8_MAX buckets ahead of the
+// current one, and the bucket of cost d can be found at index d % BUCKET_COUNT.
+#define BUCKET_COUNT (UINT8_MAX + 1)
+
+
+// stack of node ids x * height + y
+typedef struct Bucket {
+    uint32_t* ids;
+    size_t n;
+    size_t allocated;
+} Bucket;
+
+
+
+static inline void bucket_push(Bucket* bucket, const uint32_t id)
+{
+    if(bucket->n == bucket->allocated) {
+        bucket->allocated = bucket->allocated ? 2 * bucket->allocated : 64;
+        bucket->ids = realloc(bucket->ids, bucket->allocated * sizeof(uint32_t));
+        if(!bucket->ids) {
+            fprintf(stderr, "Allocation for search bucket failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    bucket->ids[bucket->n++] = id;
+}
+
+
+// id of the neighbor of node id in the direction of neighbor_bit
+static inline uint32_t neighbor_id(const Graph* const g, const uint32_t id, const uint8_t neighbor_bit)
+{
+    switch(neighbor_bit) {
+        case NEIGH_X_POS:
+            return id + g->height;
+        case NEIGH_X_NEG:
+            return id - g->height;
+        case NEIGH_Y_POS:
+            return id + 1;
+        default:
+            return id - 1;
+    }
+}
+
+static const uint8_t neighbor_bits[4] = {NEIGH_X_POS, NEIGH_X_NEG, NEIGH_Y_POS, NEIGH_Y_NEG};
+
+
+
+int16_t bucket_search_cost(const Graph* const g)
+{
+    assert(g);
+    const size_t nodes = (size_t)g->width * g->height;
+    // graph_malloc allocates the inner arrays in one block each, so they can be indexed by x * height + y
+    const uint8_t* const cost = g->node_cost[0];
+    const uint8_t* const neighbors = g->neighbors[0];
+    uint32_t* dist = malloc(nodes * sizeof(uint32_t));
+    if(!dist) {
+        fprintf(stderr, "Allocation for bucket search failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < nodes; i++) {
+        dist[i] = UINT32_MAX;
+    }
+    // Small boards only use a few buckets, so only the ones of the costs from min_dist to max_dist are
+    // initialized and freed.
+    Bucket buckets[BUCKET_COUNT];
+    size_t queued = 0; // number of entries in all buckets, including the outdated ones
+
+    const uint32_t start = (uint32_t)g->p1.x * g->height + g->p1.y;
+    const uint32_t goal = (uint32_t)g->p2.x * g->height + g->p2.y;
+    dist[start] = cost[start];
+    const uint32_t min_dist = dist[start];
+    uint32_t max_dist = min_dist;
+    buckets[min_dist % BUCKET_COUNT] = (Bucket) {0};
+    bucket_push(&buckets[min_dist % BUCKET_COUNT], start);
+    queued++;
+    int16_t result = -1;
+    for(uint32_t d = dist[start]; queued > 0 && result < 0; d++) {
+        Bucket* const bucket = &buckets[d % BUCKET_COUNT];
+        while(bucket->n > 0) {
+            const uint32_t id = bucket->ids[--bucket->n];
+            queued--;
+            if(dist[id] != d) { // outdated entry
+                continue;
+            }
+            if(id == goal) {
+                result = (int16_t)d;
+                break;
+            }
+            for(size_t k = 0; k < 4; k++) {
+                if(!(neighbors[id] & neighbor_bits[k])) {
+                    continue;
+                }
+                const uint32_t next = neighbor_id(g, id, neighbor_bits[k]);
+                const uint32_t next_dist = d + cost[next];
+                if(next_dist < dist[next]) {
+                    dist[next] = next_dist;
+                    for(; max_dist < next_dist; max_dist++) {
+                        if(max_dist - min_dist < BUCKET_COUNT - 1) {
+                            buckets[(max_dist + 1) % BUCKET_COUNT] = (Bucket) {0};
+                        }
+                    }
+                    bucket_push(&buckets[next_dist % BUCKET_COUNT], next);
+                    queued++;
+                }
+            }
+        }
+    }
+
+    for(uint32_t c = min_dist; c <= max_dist && c - min_dist < BUCKET_COUNT; c++) {
+        free(buckets[c % BUCKET_COUNT].ids);
+    }
+    free(dist);
+    return result;
+}
+
+
+
+bool zero_cost_connected(const Graph* const g)
+{
+    assert(g);
+    if(g->node_cost[g->p1.x][g->p1.y] != 0 || g->node_cost[g->p2.x][g->p2.y] != 0) {
+        return false;
+    }
+    const size_t nodes = (size_t)g->width * g->height;
+    const uint8_t* const cost = g->node_cost[0];
+    const uint8_t* const neighbors = g->neighbors[0];
+    bool* visited = calloc(nodes, sizeof(bool));
+    Bucket stack = {0};
+    if(!visited) {
+        fprintf(stderr, "Allocation for zero-cost check failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const uint32_t start = (uint32_t)g->p1.x * g->height + g->p1.y;
+    const uint32_t goal = (uint32_t)g->p2.x * g->height + g->p2.y;
+    visited[start] = true;
+    bucket_push(&stack, start);
+    bool connected = false;
+    while(stack.n > 0 && !connected) {
+        const uint32_t id = stack.ids[--stack.n];
+        connected = id == goal;
+        for(size_t k = 0; k < 4; k++) {
+            if(!(neighbors[id] & neighbor_bits[k])) {
+                continue;
+            }
+            const uint32_t next = neighbor_id(g, id, neighbor_bits[k]);
+            if(!visited[next] && cost[next] == 0) {
+                visited[next] = true;
+                bucket_push(&stack, next);
+            }
+        }
+    }
+
+    free(stack.ids);
+    free(visited);
+    return connected;
+}
@@ -0,0 +1,37 @@
+#ifndef _BUCKET_SEARCH_H
+#define _BUCKET_SEARCH_H
+
+
+/*
+ * Searches without a priority queue
+ *
+ * The cost of a path is the sum of its node costs, which are small integers (0, 1 or 2 without crossing
+ * weights, at most UINT8_MAX with them). So the frontier does not need a heap ordered by the full path
+ * metric: it can be kept in one bucket per cost, as in a 0-1 BFS generalized to small weights (Dial's
+ * algorithm). Since no node costs more than UINT8_MAX, a ring of 256 buckets is enough, and every insertion
+ * and removal is O(1). There is no heuristic and no tie-break by length, so every node that is cheaper to
+ * reach than p2 is expanded, which pays off where manhattan_distance cannot guide A* anyway.
+ *
+ * The zero-cost check floods the nodes with cost 0 that are connected to p1 and tells whether p2 is one of
+ * them, i.e. whether the minimal cost is 0, with a plain stack and a visited bit per node.
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "graph.h"
+
+
+
+// Calculate the minimal cost of a path between p1 and p2, like a_star_cost. Returns -1 if there is no path.
+int16_t bucket_search_cost(const Graph* const g);
+
+// Returns true iff p1 and p2 are connected by a path whose nodes all have cost 0, i.e. iff the minimal
+// cost of a path between them is 0.
+bool zero_cost_connected(const Graph* const g);
+
+
+
+#endif
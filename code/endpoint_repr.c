@@ -8,29 +8,28 @@
 
 
 // Comparison function for qsort
-// compare 2 int_fast32_t** by the value they are pointing to
-static int compare_int_fast32_t_ptr(const void* a, const void* b)
+// compare 2 int32_t** by the value they are pointing to
+static int compare_int32_t_ptr(const void* a, const void* b)
 {
-    const int_fast32_t x = **(const int_fast32_t* const*)a;
-    const int_fast32_t y = **(const int_fast32_t* const*)b;
+    const int32_t x = **(const int32_t* const*)a;
+    const int32_t y = **(const int32_t* const*)b;
     return (x > y) - (x < y);
 }
 
 
 
-// Given a pointer to an array of long*, reduce and update all the long.
-// Lower bound of -1 is assumend and does not have to be included
-static void reduce_worker(int_fast32_t* arr[], size_t length)
+void reduce_worker_keep(int32_t* arr[], size_t length, const int32_t max_free)
 {
-    qsort(arr, length, sizeof(int_fast32_t*), compare_int_fast32_t_ptr);
-    int_fast32_t prev_val = -1; // the previous value to compare the current value to
-    int_fast32_t sum_shifts = 0; // the sum of all shifts done so far, i.e. this has to be substracted from
-                                 // the rest of the values
+    assert(max_free >= 1);
+    qsort(arr, length, sizeof(int32_t*), compare_int32_t_ptr);
+    int32_t prev_val = -1;   // the previous value to compare the current value to
+    int32_t sum_shifts = 0;  // the sum of all shifts done so far, i.e. this has to be substracted from
+                             // the rest of the values
     for(size_t i = 0; i < length; i++) {
         *(arr[i]) -= sum_shifts; // apply all previously found shifts
-        int_fast32_t diff = *(arr[i]) - prev_val;
-        if(diff >= 3) {
-            int_fast32_t shift = diff - 2;
+        int32_t diff = *(arr[i]) - prev_val;
+        if(diff > max_free + 1) {
+            int32_t shift = diff - (max_free + 1);
             // shift has to be subtracted from the rest of the array beginning at i
             *(arr[i]) -= shift;
             sum_shifts += shift;
@@ -41,6 +40,13 @@ static void reduce_worker(int_fast32_t* arr[], size_t length)
 
 
 
+void reduce_worker(int32_t* arr[], size_t length)
+{
+    reduce_worker_keep(arr, length, 1);
+}
+
+
+
 // Simplify the grid by removing identical neighboring columns/rows.
 // Must not be called on a nullpointer.
 // For number of existing wires m, after this function both the width and the height of the grid are
@@ -54,9 +60,9 @@ void reduce(EndpointRepr* const er)
     assert(er != NULL && er->m > 0 && er->wires != NULL);
     size_t n = 2 * (size_t)er->m + 3; // the number of coordinates per direction
 
-    // use array of int_fast32_t* so the original values can be changed when going through the array
-    int_fast32_t** xs = malloc(n * sizeof(int_fast32_t*));
-    int_fast32_t** ys = malloc(n * sizeof(int_fast32_t*));
+    // use array of int32_t* so the original values can be changed when going through the array
+    int32_t** xs = malloc(n * sizeof(int32_t*));
+    int32_t** ys = malloc(n * sizeof(int32_t*));
     if(!xs || !ys) {
         fprintf(stderr, "Allocating helper arrays for reduction failed.\n");
         exit(EXIT_FAILURE);
@@ -80,3 +86,90 @@ void reduce(EndpointRepr* const er)
     free(xs);
     free(ys);
 }
+
+
+
+// Reduce the values pointed to by values like reduce_worker_keep, and return the map from the reduced
+// coordinates 0 .. size - 1 to the original ones, where size is the reduced value of *values[0].
+// Values that are not in the input are mapped to the free lines of the original gap, in order.
+static int32_t* reduce_worker_map(int32_t* values[], const size_t n, const int32_t max_free)
+{
+    int32_t** sorted = malloc(n * sizeof(int32_t*)); // reduce_worker_keep sorts the pointers
+    int32_t* before = malloc(n * sizeof(int32_t));
+    if(!sorted || !before) {
+        fprintf(stderr, "Allocating helper arrays for reduction failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < n; i++) {
+        sorted[i] = values[i];
+        before[i] = *values[i];
+    }
+    reduce_worker_keep(sorted, n, max_free);
+    free(sorted);
+
+    const int32_t size = *values[0];
+    int32_t* map = malloc((size_t)size * sizeof(int32_t));
+    bool* known = calloc((size_t)size, sizeof(bool));
+    if(!map || !known) {
+        fprintf(stderr, "Allocation for coordinate map failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < n; i++) {
+        if(*values[i] < size) {
+            map[*values[i]] = before[i];
+            known[*values[i]] = true;
+        }
+    }
+    int32_t prev = -1; // the lower bound -1 is not reduced
+    int32_t prev_original = -1;
+    for(int32_t c = 0; c < size; c++) {
+        if(known[c]) {
+            prev = c;
+            prev_original = map[c];
+        }
+        else {
+            map[c] = prev_original + (c - prev);
+        }
+    }
+    free(known);
+    free(before);
+    return map;
+}
+
+
+
+void reduce_with_points(EndpointRepr* const er, int32_t* const point_xs[], int32_t* const point_ys[],
+                        const size_t count, const int32_t max_free, int32_t** x_coords, int32_t** y_coords)
+{
+    assert(er != NULL && er->m >= 0 && max_free >= 1);
+    // like reduce, but the size has to be the first value for reduce_worker_map
+    const size_t n = 2 * (size_t)er->m + 3 + count;
+    int32_t** xs = malloc(n * sizeof(int32_t*));
+    int32_t** ys = malloc(n * sizeof(int32_t*));
+    if(!xs || !ys) {
+        fprintf(stderr, "Allocating helper arrays for reduction failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t k = 0;
+    xs[k] = &(er->width);
+    ys[k++] = &(er->height);
+    xs[k] = &(er->p1x);
+    ys[k++] = &(er->p1y);
+    xs[k] = &(er->p2x);
+    ys[k++] = &(er->p2y);
+    for(int i = 0; i < er->m; i++) {
+        xs[k] = &(er->wires[i].x1);
+        ys[k++] = &(er->wires[i].y1);
+        xs[k] = &(er->wires[i].x2);
+        ys[k++] = &(er->wires[i].y2);
+    }
+    for(size_t i = 0; i < count; i++) {
+        xs[k] = point_xs[i];
+        ys[k++] = point_ys[i];
+    }
+    assert(k == n);
+    *x_coords = reduce_worker_map(xs, n, max_free);
+    *y_coords = reduce_worker_map(ys, n, max_free);
+    free(xs);
+    free(ys);
+}
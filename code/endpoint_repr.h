@@ -10,11 +10,13 @@
 
 // Representation of a wire by the coordinates of its end points
 // It must hold that x1 <= x2 and y1 <= y2
+// The coordinates are fixed width so an array of Wire has the same layout as the packed wire arrays
+// of the binary instance format [see instance_file.h] on little-endian machines.
 typedef struct Wire {
-    int_fast32_t x1;
-    int_fast32_t y1;
-    int_fast32_t x2;
-    int_fast32_t y2;
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
 } Wire;
 
 
@@ -24,15 +26,20 @@ typedef struct Wire {
 // running a pathfinding algorithm on it.
 typedef struct EndpointRepr {
     int m;               // number of wires
-    int_fast32_t width;  // number of nodes in the x direction
-    int_fast32_t height; // number of nodes in the y direction
-    int_fast32_t p1x;    // coordinates of the start and end points
-    int_fast32_t p1y;
-    int_fast32_t p2x;
-    int_fast32_t p2y;
+    int32_t width;  // number of nodes in the x direction
+    int32_t height; // number of nodes in the y direction
+    int32_t p1x;    // coordinates of the start and end points
+    int32_t p1y;
+    int32_t p2x;
+    int32_t p2y;
     Wire* wires; // the given wire coordinates
+    uint8_t* weights; // cost of crossing each wire (1 <= weight <= WIRE_WEIGHT_MAX), NULL if every wire costs 1
 } EndpointRepr;
 
+// maximal crossing weight of a wire. The cost of a node is the sum of the weights of the wires on it
+// and saturates at UINT8_MAX.
+#define WIRE_WEIGHT_MAX 50
+
 
 
 // Simplify the grid by removing identical neighboring columns/rows.
@@ -43,6 +50,21 @@ typedef struct EndpointRepr {
 // Therefore, their product (= total number of nodes) is <= ((6*m+10)/2)^2 = (3*m+5)^2
 void reduce(EndpointRepr* const er);
 
+// Given a pointer to an array of int32_t*, reduce and update all the int32_t.
+// Lower bound of -1 is assumend and does not have to be included.
+// This is the work of reduce for one direction, exposed for the microbenchmarks.
+void reduce_worker(int32_t* arr[], size_t length);
+// Same as reduce_worker, but keep up to max_free (>= 1) free lines between two successive values instead of 1.
+void reduce_worker_keep(int32_t* arr[], size_t length, const int32_t max_free);
+
+// Reduce er like reduce, together with the additional points (*point_xs[i], *point_ys[i]) for i < count
+// (e.g. more endpoints to connect), and keep up to max_free (>= 1) free lines between two successive values.
+// Write the maps from the reduced coordinates to the original ones to x_coords and y_coords, i.e.
+// (*x_coords)[x] is the original coordinate of column x. They are newly allocated with the reduced width and
+// height as their lengths, the caller is responsible for freeing them.
+void reduce_with_points(EndpointRepr* const er, int32_t* const point_xs[], int32_t* const point_ys[],
+                        const size_t count, const int32_t max_free, int32_t** x_coords, int32_t** y_coords);
+
 
 
 #endif
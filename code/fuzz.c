@@ -0,0 +1,996 @@
+/*
+ * Differential fuzzer for the search pipelines
+ *
+ * Generates random small to medium instances and solves each one with every engine of wiring_assistant
+ * (reduction, graph and search variant), and with a plain Dijkstra on the unreduced grid that shares no
+ * code with them. The reference only relies on the definition of the problem, so it also checks the
+ * argument in endpoint_repr.h that the reduction does not change the result. Some instances get crossing
+ * weights or a bend penalty, and then only the engines supporting them are compared. The multi-net router
+ * also routes a few more nets after the one between the endpoints, and each of them is checked against the
+ * reference on the unreduced grid with the routes before it.
+ * If an engine disagrees with the reference, the instance is shrunk as long as the same engine still
+ * disagrees (removing wires, shortening wires, dropping weights and the bend penalty, removing lines of
+ * the board), and the reproducer is printed in the input format of wiring_assistant.
+ *
+ * Every case has its own seed derived from the seed of the run and its number, so a single case can be
+ * repeated with -f CASE -n 1.
+ *
+ * Usage: fuzz [-s SEED] [-f FIRST_CASE] [-n CASES] [-m MAX_WIRES] [-S MAX_SIZE] [-o FILE] [-k]
+ * -n 0 runs until the first mismatch, or forever with -k, so it can be left running as a background job.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+#include "a_star.h"
+#include "implicit_graph.h"
+#include "landmarks.h"
+#include "parallel_search.h"
+#include "bend_search.h"
+#include "bucket_search.h"
+#include "portfolio.h"
+#include "multi_net.h"
+#include "steiner.h"
+#include "instance_gen.h"
+#include "util.h"
+
+
+
+#define DEFAULT_SEED      1006
+#define DEFAULT_CASES     10000
+#define DEFAULT_MAX_WIRES 24
+#define DEFAULT_MAX_SIZE  120
+#define SMALL_SIZE        12 // half of the boards are at most this large, where mismatches are easiest to read
+#define MAX_BEND_PENALTY  20
+#define MAX_EXTRA_NETS    4  // nets routed by the multi-net router after the one between the endpoints
+#define PROGRESS_SECONDS  10 // interval of the progress line
+#define RESULT_INVALID    INT16_MIN // an engine returned a path that is not a valid path of the graph
+
+
+
+// an unreduced instance and the bend penalty to solve it with
+typedef struct FuzzCase {
+    EndpointRepr er; // er.wires (and er.weights, if not NULL) are owned by the case
+    uint16_t bend_penalty;
+    size_t extra_net_count;
+    Net extra_nets[MAX_EXTRA_NETS]; // only routed by the multi-net router, after the net from p1 to p2
+} FuzzCase;
+
+// input format of wiring_assistant to print a case in
+typedef enum CaseFormat {
+    FORMAT_PLAIN,
+    FORMAT_NETS,      // -N, with the extra nets
+    FORMAT_TERMINALS, // -M, with p1 and p2 as the terminals
+} CaseFormat;
+
+// A pipeline under test. solve gets the unreduced case and returns the minimal cost, -1 if there is no
+// path, or RESULT_INVALID if the path found by the engine is not valid.
+typedef struct Engine {
+    const char* name;
+    const char* options; // options of wiring_assistant that select the engine, for the reproducer
+    bool weights;        // supports crossing weights
+    bool bends;          // supports a bend penalty
+    int16_t (*solve)(const FuzzCase* const fc);
+} Engine;
+
+typedef struct FuzzConfig {
+    uint64_t seed;
+    unsigned long first_case;
+    unsigned long cases; // 0 for no limit
+    int max_wires;
+    int32_t max_size;
+    const char* output; // file to append the reproducers to, NULL to only print them
+    bool keep_going;    // continue after a mismatch
+} FuzzConfig;
+
+
+
+/*
+ * Cases
+ */
+
+static void case_free(FuzzCase* fc)
+{
+    free(fc->er.wires);
+    free(fc->er.weights);
+    fc->er.wires = NULL;
+    fc->er.weights = NULL;
+}
+
+
+// deep copy of fc, the caller is responsible for freeing it with case_free
+static FuzzCase case_copy(const FuzzCase* const fc)
+{
+    FuzzCase copy = *fc;
+    copy.er.wires = malloc(((size_t)fc->er.m + 1) * sizeof(Wire)); // + 1 so it is never malloc(0)
+    copy.er.weights = fc->er.weights ? malloc((size_t)fc->er.m + 1) : NULL;
+    if(!copy.er.wires || (fc->er.weights && !copy.er.weights)) {
+        fprintf(stderr, "Allocation for fuzz case failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy.er.wires, fc->er.wires, (size_t)fc->er.m * sizeof(Wire));
+    if(fc->er.weights) {
+        memcpy(copy.er.weights, fc->er.weights, (size_t)fc->er.m);
+    }
+    return copy;
+}
+
+
+// Generate case number index of the run with the given seed.
+static FuzzCase case_generate(const FuzzConfig* const config, const unsigned long index)
+{
+    GenRng rng = {config->seed ^ ((uint64_t)index * UINT64_C(0xD1B54A32D192ED03))};
+    gen_next(&rng); // decorrelate neighboring cases
+    const int32_t max_size = gen_below(&rng, 2) ? (config->max_size < SMALL_SIZE ? config->max_size : SMALL_SIZE)
+                                                : config->max_size;
+    const int32_t size = 2 + (int32_t)gen_below(&rng, (uint32_t)max_size - 1);
+    const int m = 1 + (int)gen_below(&rng, (uint32_t)config->max_wires); // reduce requires at least one wire
+    FuzzCase fc = {.bend_penalty = 0};
+    gen_instance(&fc.er, &rng, m, size);
+    if(gen_below(&rng, 3) == 0) {
+        fc.er.weights = malloc((size_t)m + 1);
+        if(!fc.er.weights) {
+            fprintf(stderr, "Allocation for fuzz case failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        for(int i = 0; i < m; i++) { // mostly small weights, so that they compete with the detours
+            fc.er.weights[i] = (uint8_t)(1 + gen_below(&rng, gen_below(&rng, 4) ? 4 : WIRE_WEIGHT_MAX));
+        }
+    }
+    if(gen_below(&rng, 3) == 0) {
+        fc.bend_penalty = (uint16_t)(1 + gen_below(&rng, MAX_BEND_PENALTY));
+    }
+    fc.extra_net_count = 1 + gen_below(&rng, MAX_EXTRA_NETS);
+    for(size_t i = 0; i < fc.extra_net_count; i++) {
+        Net* const net = &fc.extra_nets[i];
+        net->p1x = (int32_t)gen_below(&rng, (uint32_t)size);
+        net->p1y = (int32_t)gen_below(&rng, (uint32_t)size);
+        net->p2x = (int32_t)gen_below(&rng, (uint32_t)size);
+        net->p2y = (int32_t)gen_below(&rng, (uint32_t)size);
+    }
+    return fc;
+}
+
+
+// Print fc in the input format of wiring_assistant.
+static void case_print(FILE* file, const FuzzCase* const fc, const CaseFormat format)
+{
+    const EndpointRepr* const er = &fc->er;
+    fprintf(file, "%d %" PRId32, er->m, er->width);
+    if(format != FORMAT_PLAIN) {
+        fprintf(file, " %zu", format == FORMAT_NETS ? 1 + fc->extra_net_count : 2);
+    }
+    fprintf(file, "\n");
+    for(int i = 0; i < er->m; i++) {
+        const Wire* const w = &er->wires[i];
+        fprintf(file, "%s%" PRId32 " %" PRId32 " %" PRId32 " %" PRId32, i ? " " : "", w->x1, w->y1, w->x2, w->y2);
+        if(er->weights) {
+            fprintf(file, " %d", er->weights[i]);
+        }
+    }
+    fprintf(file, "\n%" PRId32 " %" PRId32 " %" PRId32 " %" PRId32, er->p1x, er->p1y, er->p2x, er->p2y);
+    for(size_t i = 0; format == FORMAT_NETS && i < fc->extra_net_count; i++) {
+        const Net* const net = &fc->extra_nets[i];
+        fprintf(file, " %" PRId32 " %" PRId32 " %" PRId32 " %" PRId32, net->p1x, net->p1y, net->p2x, net->p2y);
+    }
+    fprintf(file, "\n0 0\n");
+}
+
+
+
+/*
+ * Reference
+ *
+ * Dijkstra on the unreduced grid over the states (node, axis of the last step), with a binary heap of its
+ * own. The cost of a path is the sum of the costs of its nodes, including start and end, where the cost of
+ * a node is the sum of the weights of the wires on it (saturating at UINT8_MAX), plus the bend penalty for
+ * every change of the axis. The first step is never a bend, so the start node is entered on both axes.
+ * Two nodes are neighbors unless they are consecutive nodes of the same wire.
+ */
+
+typedef struct RefEntry {
+    long dist;
+    size_t state; // 2 * (x * height + y) + axis, axis 0 is x and axis 1 is y
+} RefEntry;
+
+typedef struct RefHeap {
+    RefEntry* entries;
+    size_t n;
+    size_t allocated;
+} RefHeap;
+
+
+static void ref_heap_push(RefHeap* heap, const RefEntry entry)
+{
+    if(heap->n == heap->allocated) {
+        heap->allocated = heap->allocated ? 2 * heap->allocated : 64;
+        heap->entries = realloc(heap->entries, heap->allocated * sizeof(RefEntry));
+        if(!heap->entries) {
+            fprintf(stderr, "Allocation for reference heap failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t i = heap->n++;
+    while(i > 0 && heap->entries[(i - 1) / 2].dist > entry.dist) {
+        heap->entries[i] = heap->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->entries[i] = entry;
+}
+
+
+static RefEntry ref_heap_pop(RefHeap* heap)
+{
+    const RefEntry top = heap->entries[0];
+    const RefEntry last = heap->entries[--heap->n];
+    size_t i = 0;
+    while(2 * i + 1 < heap->n) {
+        size_t child = 2 * i + 1;
+        if(child + 1 < heap->n && heap->entries[child + 1].dist < heap->entries[child].dist) {
+            child++;
+        }
+        if(heap->entries[child].dist >= last.dist) {
+            break;
+        }
+        heap->entries[i] = heap->entries[child];
+        i = child;
+    }
+    heap->entries[i] = last;
+    return top;
+}
+
+
+// the unreduced grid of an instance, with the routes added to it by the multi-net check
+typedef struct RefGrid {
+    size_t width;
+    size_t height;
+    long* cost;      // cost of node x * height + y
+    bool* blocked_x; // no edge between (x, y) and (x + 1, y)
+    bool* blocked_y; // no edge between (x, y) and (x, y + 1)
+} RefGrid;
+
+
+// The caller is responsible for freeing the grid with ref_grid_free.
+static RefGrid ref_grid_new(const EndpointRepr* const er)
+{
+    const size_t w = (size_t)er->width;
+    const size_t h = (size_t)er->height;
+    RefGrid grid = {w, h, calloc(w * h, sizeof(long)), calloc(w * h, sizeof(bool)), calloc(w * h, sizeof(bool))};
+    if(!grid.cost || !grid.blocked_x || !grid.blocked_y) {
+        fprintf(stderr, "Allocation for reference grid failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < er->m; i++) {
+        const Wire* const wire = &er->wires[i];
+        const long weight = er->weights ? er->weights[i] : 1;
+        const size_t x1 = (size_t)wire->x1, y1 = (size_t)wire->y1, x2 = (size_t)wire->x2, y2 = (size_t)wire->y2;
+        for(size_t x = x1; x <= x2; x++) {
+            for(size_t y = y1; y <= y2; y++) {
+                grid.cost[x * h + y] += weight;
+                if(x < x2) {
+                    grid.blocked_x[x * h + y] = true;
+                }
+                if(y < y2) {
+                    grid.blocked_y[x * h + y] = true;
+                }
+            }
+        }
+    }
+    for(size_t i = 0; i < w * h; i++) {
+        grid.cost[i] = grid.cost[i] < UINT8_MAX ? grid.cost[i] : UINT8_MAX;
+    }
+    return grid;
+}
+
+
+static void ref_grid_free(RefGrid* grid)
+{
+    free(grid->cost);
+    free(grid->blocked_x);
+    free(grid->blocked_y);
+    grid->cost = NULL;
+    grid->blocked_x = NULL;
+    grid->blocked_y = NULL;
+}
+
+
+// Minimal cost of a path between the nodes start and goal of grid, -1 if there is none.
+static long ref_grid_search(const RefGrid* const grid, const size_t start, const size_t goal,
+                            const uint16_t bend_penalty)
+{
+    const size_t w = grid->width;
+    const size_t h = grid->height;
+    const long* const cost = grid->cost;
+    long* dist = malloc(2 * w * h * sizeof(long));
+    if(!dist) {
+        fprintf(stderr, "Allocation for reference grid failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < 2 * w * h; i++) {
+        dist[i] = LONG_MAX;
+    }
+
+    RefHeap heap = {0};
+    dist[2 * start] = dist[2 * start + 1] = cost[start];
+    ref_heap_push(&heap, (RefEntry) {cost[start], 2 * start});
+    ref_heap_push(&heap, (RefEntry) {cost[start], 2 * start + 1});
+    long result = -1;
+    while(heap.n > 0) {
+        const RefEntry current = ref_heap_pop(&heap);
+        if(current.dist > dist[current.state]) { // outdated entry
+            continue;
+        }
+        const size_t node = current.state / 2;
+        const size_t axis = current.state % 2;
+        if(node == goal) {
+            result = current.dist;
+            break;
+        }
+        const size_t x = node / h;
+        const size_t y = node % h;
+        const bool can_move[4] = {x + 1 < w && !grid->blocked_x[node], x > 0 && !grid->blocked_x[node - h],
+                                  y + 1 < h && !grid->blocked_y[node], y > 0 && !grid->blocked_y[node - 1]};
+        const size_t next[4] = {node + h, node - h, node + 1, node - 1};
+        for(size_t d = 0; d < 4; d++) {
+            if(!can_move[d]) {
+                continue;
+            }
+            const size_t next_axis = d / 2;
+            const long next_dist = current.dist + cost[next[d]] + (next_axis != axis ? bend_penalty : 0);
+            const size_t next_state = 2 * next[d] + next_axis;
+            if(next_dist < dist[next_state]) {
+                dist[next_state] = next_dist;
+                ref_heap_push(&heap, (RefEntry) {next_dist, next_state});
+            }
+        }
+    }
+    free(heap.entries);
+    free(dist);
+    return result;
+}
+
+
+// Minimal cost of a path between the endpoints of the unreduced instance, -1 if there is none.
+static long reference_cost(const FuzzCase* const fc)
+{
+    const EndpointRepr* const er = &fc->er;
+    RefGrid grid = ref_grid_new(er);
+    const size_t h = grid.height;
+    const long result = ref_grid_search(&grid, (size_t)er->p1x * h + (size_t)er->p1y,
+                                        (size_t)er->p2x * h + (size_t)er->p2y, fc->bend_penalty);
+    ref_grid_free(&grid);
+    return result;
+}
+
+
+// Add a route of the multi-net router for net to grid like graph_add_route, after checking that it is a
+// path of grid between the endpoints of net whose cost is route->cost. Its nodes are translated with the
+// coordinate maps of result, and the steps over the lines that the reduction removed are filled in.
+// Returns false if the check fails.
+static bool ref_grid_add_route(RefGrid* grid, const Route* const route, const MultiNetResult* const result,
+                               const Net* const net)
+{
+    const size_t h = grid->height;
+    size_t* nodes = malloc(grid->width * h * sizeof(size_t));
+    if(!nodes) {
+        fprintf(stderr, "Allocation for reference route failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    size_t x = (size_t)result->x_coords[route->path[0].x];
+    size_t y = (size_t)result->y_coords[route->path[0].y];
+    nodes[n++] = x * h + y;
+    bool valid = x == (size_t)net->p1x && y == (size_t)net->p1y;
+    for(size_t i = 1; i < route->length && valid; i++) {
+        const size_t next_x = (size_t)result->x_coords[route->path[i].x];
+        const size_t next_y = (size_t)result->y_coords[route->path[i].y];
+        valid = (next_x == x) != (next_y == y);
+        while(valid && (x != next_x || y != next_y)) {
+            const size_t node = x * h + y;
+            if(x != next_x) {
+                valid = !grid->blocked_x[x < next_x ? node : node - h];
+                x = x < next_x ? x + 1 : x - 1;
+            }
+            else {
+                valid = !grid->blocked_y[y < next_y ? node : node - 1];
+                y = y < next_y ? y + 1 : y - 1;
+            }
+            nodes[n++] = x * h + y; // a route visits every node at most once
+        }
+    }
+    valid = valid && x == (size_t)net->p2x && y == (size_t)net->p2y;
+    long sum = 0;
+    for(size_t i = 0; i < n && valid; i++) {
+        sum += grid->cost[nodes[i]];
+    }
+    valid = valid && sum == route->cost;
+    for(size_t i = 0; i < n && valid; i++) {
+        grid->cost[nodes[i]] = grid->cost[nodes[i]] < UINT8_MAX ? grid->cost[nodes[i]] + 1 : UINT8_MAX;
+        if(i > 0) { // remove the edge to the previous node
+            const size_t a = nodes[i - 1] < nodes[i] ? nodes[i - 1] : nodes[i];
+            const size_t b = nodes[i - 1] < nodes[i] ? nodes[i] : nodes[i - 1];
+            bool* const blocked = b - a == h ? grid->blocked_x : grid->blocked_y;
+            blocked[a] = true;
+        }
+    }
+    free(nodes);
+    return valid;
+}
+
+
+
+/*
+ * Engines
+ */
+
+// Reduce a copy of the instance of fc into reduced and build its graph, like wiring_assistant does.
+// The caller is responsible for freeing both with graph_free and case_free.
+static Graph* reduced_graph(const FuzzCase* const fc, FuzzCase* reduced)
+{
+    *reduced = case_copy(fc);
+    reduce(&reduced->er);
+    return build_graph(&reduced->er);
+}
+
+
+// Check that path is a path of g from p1 to p2 whose cost is cost.
+static bool valid_path(const Graph* const g, const Uint16Point* const path, const size_t length, const int16_t cost)
+{
+    if(length == 0 || path[0].x != g->p1.x || path[0].y != g->p1.y || path[length - 1].x != g->p2.x ||
+       path[length - 1].y != g->p2.y) {
+        return false;
+    }
+    long sum = g->node_cost[path[0].x][path[0].y];
+    for(size_t i = 1; i < length; i++) {
+        const Uint16Point p = path[i - 1];
+        const Uint16Point q = path[i];
+        uint8_t direction = 0;
+        if(q.x == (uint16_t)(p.x + 1) && q.y == p.y) {
+            direction = NEIGH_X_POS;
+        }
+        else if((uint16_t)(q.x + 1) == p.x && q.y == p.y) {
+            direction = NEIGH_X_NEG;
+        }
+        else if(q.x == p.x && q.y == (uint16_t)(p.y + 1)) {
+            direction = NEIGH_Y_POS;
+        }
+        else if(q.x == p.x && (uint16_t)(q.y + 1) == p.y) {
+            direction = NEIGH_Y_NEG;
+        }
+        if(!(g->neighbors[p.x][p.y] & direction)) { // also if direction is 0, i.e. p and q are not adjacent
+            return false;
+        }
+        sum += g->node_cost[q.x][q.y];
+    }
+    return sum == cost;
+}
+
+
+static int16_t solve_a_star(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = a_star_cost(g, manhattan_distance);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_a_star_path(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    Uint16Point* path = malloc((size_t)g->width * g->height * sizeof(Uint16Point));
+    if(!path) {
+        fprintf(stderr, "Allocation for path failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t length;
+    int16_t result = a_star_path(g, manhattan_distance, path, &length);
+    if(result >= 0 && !valid_path(g, path, length, result)) {
+        result = RESULT_INVALID;
+    }
+    free(path);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_a_star_path_map(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    bool** path_map = new_path_map(g->width, g->height);
+    if(!path_map) {
+        fprintf(stderr, "Allocation for path map failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    int16_t result = a_star_path_map(g, manhattan_distance, path_map);
+    if(result >= 0 && (!path_map[g->p1.x][g->p1.y] || !path_map[g->p2.x][g->p2.y])) {
+        result = RESULT_INVALID;
+    }
+    free_path_map(path_map);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_compact(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = a_star_cost_compact(g, manhattan_distance);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_implicit(const FuzzCase* const fc)
+{
+    FuzzCase reduced = case_copy(fc);
+    reduce(&reduced.er);
+    ImplicitGraph* ig = implicit_graph_new(&reduced.er);
+    const int16_t result = a_star_implicit_cost(ig, manhattan_distance);
+    implicit_graph_free(ig);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_indexed_queue(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    a_star_use_indexed_queue(true);
+    const int16_t result = a_star_cost(g, manhattan_distance);
+    a_star_use_indexed_queue(false);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_bucket(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = bucket_search_cost(g);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_zero_check(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = portfolio_solve(g, manhattan_distance, ENGINE_ZERO_CHECK);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_landmarks(const FuzzCase* const fc)
+{
+    FuzzCase reduced = case_copy(fc);
+    LandmarkSet* landmarks = landmarks_compute(&reduced.er, 4); // on the board without the endpoints
+    int32_t* x_coords;
+    int32_t* y_coords;
+    reduce_with_points(&reduced.er, NULL, NULL, 0, 1, &x_coords, &y_coords);
+    Graph* g = build_graph(&reduced.er);
+    landmarks_activate(landmarks, g, x_coords, y_coords);
+    const int16_t result = a_star_cost(g, landmark_heuristic);
+    landmarks_free(landmarks);
+    free(x_coords);
+    free(y_coords);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_anytime(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const AnytimeResult anytime = a_star_anytime(g, manhattan_distance, (AnytimeBudget) {0, 0}, NULL);
+    graph_free(g);
+    case_free(&reduced);
+    // without a budget the result has to be proven minimal
+    return anytime.lower_bound == anytime.cost ? anytime.cost : RESULT_INVALID;
+}
+
+
+static int16_t solve_parallel(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = parallel_search_cost(g, 2);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+static int16_t solve_bends(const FuzzCase* const fc)
+{
+    FuzzCase reduced;
+    Graph* g = reduced_graph(fc, &reduced);
+    const int16_t result = bend_search_cost(g, manhattan_distance, fc->bend_penalty);
+    graph_free(g);
+    case_free(&reduced);
+    return result;
+}
+
+
+// Route the net between the endpoints and then the extra nets of fc. Every route is replayed on the
+// unreduced grid, where the routes before it are wires, and each extra net has to cost as much as the
+// cheapest path there. Returns the cost of the first net, which the driver compares to the reference.
+static int16_t solve_multi_net(const FuzzCase* const fc)
+{
+    FuzzCase copy = case_copy(fc); // multi_net_route reduces it
+    Net nets[1 + MAX_EXTRA_NETS] = {{fc->er.p1x, fc->er.p1y, fc->er.p2x, fc->er.p2y}};
+    memcpy(&nets[1], fc->extra_nets, fc->extra_net_count * sizeof(Net));
+    const size_t net_count = 1 + fc->extra_net_count;
+    MultiNetResult mn = multi_net_route(&copy.er, nets, (int)net_count, NET_ORDER_INPUT, manhattan_distance);
+    RefGrid grid = ref_grid_new(&fc->er);
+    const size_t h = grid.height;
+    int16_t result = mn.routes[0].cost;
+    for(size_t i = 0; i < net_count && result != RESULT_INVALID; i++) {
+        const Route* const route = &mn.routes[i];
+        const long expected = i == 0 ? route->cost
+                                     : ref_grid_search(&grid, (size_t)nets[i].p1x * h + (size_t)nets[i].p1y,
+                                                       (size_t)nets[i].p2x * h + (size_t)nets[i].p2y, 0);
+        if(route->cost != expected || (route->cost >= 0 && !ref_grid_add_route(&grid, route, &mn, &nets[i]))) {
+            result = RESULT_INVALID;
+        }
+    }
+    ref_grid_free(&grid);
+    multi_net_result_free(&mn);
+    case_free(&copy);
+    return result;
+}
+
+
+static int16_t solve_steiner(const FuzzCase* const fc)
+{
+    FuzzCase copy = case_copy(fc); // steiner_route reduces it
+    const Terminal terminals[2] = {{fc->er.p1x, fc->er.p1y}, {fc->er.p2x, fc->er.p2y}};
+    SteinerTree tree = steiner_route(&copy.er, terminals, 2);
+    int16_t result = (int16_t)tree.cost;
+    if(result >= 0) {
+        // the tree has to contain both endpoints, and its cost is the sum of the costs of its nodes
+        const Graph* const g = tree.graph;
+        long sum = 0;
+        for(uint16_t x = 0; x < g->width; x++) {
+            for(uint16_t y = 0; y < g->height; y++) {
+                sum += tree.tree_map[x][y] ? g->node_cost[x][y] : 0;
+            }
+        }
+        if(sum != result || !tree.tree_map[g->p1.x][g->p1.y] || !tree.tree_map[g->p2.x][g->p2.y] ||
+           (tree.segment_count == 0) != (fc->er.p1x == fc->er.p2x && fc->er.p1y == fc->er.p2y)) {
+            result = RESULT_INVALID;
+        }
+    }
+    steiner_tree_free(&tree);
+    case_free(&copy);
+    return result;
+}
+
+
+static const Engine engines[] = {
+    {"a_star_cost", "", true, false, solve_a_star},
+    {"a_star_path", "", true, false, solve_a_star_path},
+    {"a_star_path_map", "-p", true, false, solve_a_star_path_map},
+    {"a_star_cost_compact", "-c", true, false, solve_compact},
+    {"a_star_implicit_cost", "-i", false, false, solve_implicit},
+    {"a_star_cost+indexed_queue", "-Q", true, false, solve_indexed_queue},
+    {"bucket_search_cost", "-E bucket", true, false, solve_bucket},
+    {"zero_cost_connected+a_star_cost", "-E zero", true, false, solve_zero_check},
+    {"a_star_cost+landmarks", "-L 4", true, false, solve_landmarks},
+    {"a_star_anytime", "-e 1000000000", true, false, solve_anytime},
+    {"parallel_search_cost/2", "-j 2", true, false, solve_parallel},
+    {"bend_search_cost", "", true, true, solve_bends}, // -B with the penalty of the case
+    {"multi_net_route", "-N input", true, false, solve_multi_net},
+    {"steiner_route", "-M", true, false, solve_steiner},
+};
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+
+static bool engine_applies(const Engine* const engine, const FuzzCase* const fc)
+{
+    return (engine->weights || !fc->er.weights) && (engine->bends || fc->bend_penalty == 0);
+}
+
+
+// Does engine disagree with the reference on fc? The results are written to result and expected.
+static bool mismatch(const Engine* const engine, const FuzzCase* const fc, int16_t* result, long* expected)
+{
+    *expected = reference_cost(fc);
+    *result = engine->solve(fc);
+    return *result != *expected;
+}
+
+
+
+/*
+ * Shrinking
+ */
+
+// Replace fc with candidate and return true if engine still disagrees on candidate, else free candidate.
+static bool try_candidate(const Engine* const engine, FuzzCase* fc, FuzzCase* candidate)
+{
+    int16_t result;
+    long expected;
+    if(engine_applies(engine, candidate) && mismatch(engine, candidate, &result, &expected)) {
+        case_free(fc);
+        *fc = *candidate;
+        return true;
+    }
+    case_free(candidate);
+    return false;
+}
+
+
+static void remove_wire(FuzzCase* fc, const size_t i)
+{
+    const size_t m = (size_t)fc->er.m - 1;
+    memmove(&fc->er.wires[i], &fc->er.wires[i + 1], (m - i) * sizeof(Wire));
+    if(fc->er.weights) {
+        memmove(&fc->er.weights[i], &fc->er.weights[i + 1], m - i);
+    }
+    fc->er.m = (int)m;
+}
+
+
+// coordinate v after removing line, all coordinates are >= 0
+static inline int32_t shift_down(const int32_t v, const int32_t line)
+{
+    return (int32_t)((uint32_t)v - (v > line));
+}
+
+// Remove column and row line of the board. The coordinates behind it move one line down, so the ones on
+// it end up on the following line (on the previous one for the last line), and the wires that collapse to
+// a single point are removed. The board must be larger than 2. May leave fc without wires.
+static void remove_line(FuzzCase* fc, const int32_t removed)
+{
+    EndpointRepr* const er = &fc->er;
+    const int32_t line = removed < er->width - 1 ? removed : removed - 1;
+    er->width--;
+    er->height--;
+    int32_t* coords[] = {&er->p1x, &er->p1y, &er->p2x, &er->p2y};
+    for(size_t k = 0; k < 4; k++) {
+        *coords[k] = shift_down(*coords[k], line);
+    }
+    for(size_t i = 0; i < fc->extra_net_count; i++) {
+        Net* const net = &fc->extra_nets[i];
+        net->p1x = shift_down(net->p1x, line);
+        net->p1y = shift_down(net->p1y, line);
+        net->p2x = shift_down(net->p2x, line);
+        net->p2y = shift_down(net->p2y, line);
+    }
+    for(size_t i = (size_t)er->m; i-- > 0;) {
+        Wire* const w = &er->wires[i];
+        w->x1 = shift_down(w->x1, line);
+        w->y1 = shift_down(w->y1, line);
+        w->x2 = shift_down(w->x2, line);
+        w->y2 = shift_down(w->y2, line);
+        if(w->x1 == w->x2 && w->y1 == w->y2) {
+            remove_wire(fc, i);
+        }
+    }
+}
+
+
+// Shrink fc as long as engine disagrees with the reference on it, until no single step works anymore.
+static void shrink(const Engine* const engine, FuzzCase* fc)
+{
+    bool progress = true;
+    while(progress) {
+        progress = false;
+        if(fc->bend_penalty > 0) {
+            FuzzCase candidate = case_copy(fc);
+            candidate.bend_penalty = 0;
+            progress |= try_candidate(engine, fc, &candidate);
+        }
+        if(fc->er.weights) {
+            FuzzCase candidate = case_copy(fc);
+            free(candidate.er.weights);
+            candidate.er.weights = NULL;
+            progress |= try_candidate(engine, fc, &candidate);
+        }
+        for(size_t i = fc->extra_net_count; i-- > 0;) {
+            FuzzCase candidate = case_copy(fc);
+            candidate.extra_net_count--;
+            memmove(&candidate.extra_nets[i], &candidate.extra_nets[i + 1],
+                    (candidate.extra_net_count - i) * sizeof(Net));
+            progress |= try_candidate(engine, fc, &candidate);
+        }
+        for(size_t i = (size_t)fc->er.m; i-- > 0 && fc->er.m > 1;) {
+            FuzzCase candidate = case_copy(fc);
+            remove_wire(&candidate, i);
+            progress |= try_candidate(engine, fc, &candidate);
+        }
+        for(size_t i = 0; i < (size_t)fc->er.m; i++) { // shorten from either end
+            for(int end = 0; end < 2; end++) {
+                FuzzCase candidate = case_copy(fc);
+                Wire* const w = &candidate.er.wires[i];
+                int32_t* const lo = w->x1 == w->x2 ? &w->y1 : &w->x1;
+                int32_t* const hi = w->x1 == w->x2 ? &w->y2 : &w->x2;
+                if((uint32_t)*hi - (uint32_t)*lo < 2) {
+                    case_free(&candidate);
+                    break;
+                }
+                *(end ? hi : lo) += end ? -1 : 1;
+                progress |= try_candidate(engine, fc, &candidate);
+            }
+        }
+        for(size_t line = (size_t)fc->er.width; line-- > 0 && fc->er.width > 2;) {
+            FuzzCase candidate = case_copy(fc);
+            remove_line(&candidate, (int32_t)line);
+            if(candidate.er.m == 0) {
+                case_free(&candidate);
+                continue;
+            }
+            progress |= try_candidate(engine, fc, &candidate);
+        }
+    }
+}
+
+
+
+/*
+ * Driver
+ */
+
+static void report(const FuzzConfig* const config, const unsigned long index, const Engine* const engine,
+                   const FuzzCase* const fc, const int16_t result, const long expected)
+{
+    FILE* output = config->output ? fopen(config->output, "a") : NULL;
+    if(config->output && !output) {
+        fprintf(stderr, "Opening `%s' failed, only printing the reproducer.\n", config->output);
+    }
+    FILE* files[] = {stdout, output};
+    for(size_t k = 0; k < 2 && files[k]; k++) {
+        fprintf(files[k], "MISMATCH seed %" PRIu64 " case %lu: %s returned %d, the reference %ld\n", config->seed,
+                index, engine->name, result, expected);
+        fprintf(files[k], "reproducer for wiring_assistant%s%s%s", *engine->options ? " " : "", engine->options,
+                fc->er.weights ? " -W" : "");
+        if(engine->bends) {
+            fprintf(files[k], " -B %d", fc->bend_penalty);
+        }
+        fprintf(files[k], ":\n");
+        const CaseFormat format = strncmp(engine->options, "-N", 2) == 0 ? FORMAT_NETS
+                                  : strcmp(engine->options, "-M") == 0   ? FORMAT_TERMINALS
+                                                                         : FORMAT_PLAIN;
+        case_print(files[k], fc, format);
+        fflush(files[k]);
+    }
+    if(output) {
+        fclose(output);
+    }
+}
+
+
+// Run all applicable engines on case number index. Returns the number of mismatching engines.
+static unsigned fuzz_case(const FuzzConfig* const config, const unsigned long index)
+{
+    FuzzCase fc = case_generate(config, index);
+    const long expected = reference_cost(&fc);
+    unsigned mismatches = 0;
+    for(size_t e = 0; e < ENGINE_COUNT; e++) {
+        const Engine* const engine = &engines[e];
+        if(!engine_applies(engine, &fc)) {
+            continue;
+        }
+        int16_t result = engine->solve(&fc);
+        if(result == expected) {
+            continue;
+        }
+        mismatches++;
+        long shrunk_expected = expected;
+        FuzzCase shrunk = case_copy(&fc);
+        shrink(engine, &shrunk);
+        mismatch(engine, &shrunk, &result, &shrunk_expected);
+        report(config, index, engine, &shrunk, result, shrunk_expected);
+        case_free(&shrunk);
+    }
+    case_free(&fc);
+    return mismatches;
+}
+
+
+static double seconds_since(const struct timespec* const start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+int main(int argc, char* argv[])
+{
+    FuzzConfig config = {.seed = DEFAULT_SEED, .cases = DEFAULT_CASES, .max_wires = DEFAULT_MAX_WIRES,
+                         .max_size = DEFAULT_MAX_SIZE};
+    int opt;
+    while((opt = getopt(argc, argv, "s:f:n:m:S:o:k")) != -1) {
+        unsigned long value = 0;
+        const bool numeric = opt == 's' || opt == 'f' || opt == 'n' || opt == 'm' || opt == 'S';
+        if(numeric && !parse_ulong_arg(optarg, &value)) {
+            fprintf(stderr, "Invalid argument `%s' for option -%c.\n", optarg, opt);
+            return EXIT_FAILURE;
+        }
+        switch(opt) {
+            case 's':
+                config.seed = value;
+                break;
+            case 'f':
+                config.first_case = value;
+                break;
+            case 'n':
+                config.cases = value;
+                break;
+            case 'm':
+                if(value < 1 || value > 200) {
+                    fprintf(stderr, "Invalid maximal number of wires `%s' (1 to 200).\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                config.max_wires = (int)value;
+                break;
+            case 'S':
+                if(value < 2 || value > 2000) {
+                    fprintf(stderr, "Invalid maximal board size `%s' (2 to 2000).\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                config.max_size = (int32_t)value;
+                break;
+            case 'o':
+                config.output = optarg;
+                break;
+            case 'k':
+                config.keep_going = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s SEED] [-f FIRST_CASE] [-n CASES] [-m MAX_WIRES] [-S MAX_SIZE] [-o FILE] [-k]\n",
+                        argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double next_progress = PROGRESS_SECONDS;
+    unsigned long done = 0;
+    unsigned long mismatches = 0;
+    for(unsigned long index = config.first_case; config.cases == 0 || done < config.cases; index++) {
+        mismatches += fuzz_case(&config, index);
+        done++;
+        if(mismatches && !config.keep_going) {
+            break;
+        }
+        if(seconds_since(&start) >= next_progress) {
+            printf("%lu cases, %lu mismatches, %.0f s\n", done, mismatches, seconds_since(&start));
+            fflush(stdout);
+            next_progress += PROGRESS_SECONDS;
+        }
+    }
+    printf("%lu cases (%lu to %lu) with seed %" PRIu64 ", %lu mismatches, %.1f s\n", done, config.first_case,
+           config.first_case + done - 1, config.seed, mismatches, seconds_since(&start));
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
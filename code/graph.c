@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <assert.h>
 
@@ -14,20 +15,22 @@ void print_graph(Graph* const g, bool** path_map)
     const char* neighbor_symbol[] = {"·", "╶", "╴", "─", "╵", "└", "┘", "┴",
                                      "╷", "┌", "┐", "┬", "│", "├", "┤", "┼"};
 
-    const char* cost_color[] = {"37", "1;32", "1;36", "1;33", "1;31"};
+    const char* cost_color[] = {"37", "1;32", "1;36", "1;33", "1;31"}; // the last color is used for all costs >= 4
+    const uint8_t max_color = sizeof(cost_color) / sizeof(cost_color[0]) - 1;
     assert(g->height <= INT16_MAX); // assert that it fits into an int16_t (line below)
     for(int16_t y = (int16_t)g->height - 1; y >= 0; y--) {
         for(uint16_t x = 0; x < g->width; x++) {
             bool is_start_or_end = (g->p1.x == x && g->p1.y == y) || (g->p2.x == x && g->p2.y == y);
             bool is_part_of_path = (path_map != NULL) && path_map[x][y];
-            printf("\033[0;%s%s%sm%s", cost_color[g->node_cost[x][y]], is_start_or_end ? ";43" : "",
+            const uint8_t color = g->node_cost[x][y] < max_color ? g->node_cost[x][y] : max_color;
+            printf("\033[0;%s%s%sm%s", cost_color[color], is_start_or_end ? ";43" : "",
                    is_part_of_path ? ";5" : "", neighbor_symbol[g->neighbors[x][y]]);
         }
         printf("\033[0m\n");
     }
     printf("width = %" PRIu16 ", height = %" PRIu16 "\n", g->width, g->height);
     printf("Node cost (number of intersections): \033[0;%sm0\033[0m, \033[0;%sm1\033[0m, "
-           "\033[0;%sm2\033[0m, \033[0;%sm3\033[0m, \033[0;%sm4\033[0m;\n",
+           "\033[0;%sm2\033[0m, \033[0;%sm3\033[0m, \033[0;%sm4+\033[0m;\n",
            cost_color[0], cost_color[1], cost_color[2], cost_color[3], cost_color[4]);
     printf("\033[0;43m \033[0m = Points to connect\n\n");
 }
@@ -75,3 +78,99 @@ Graph* graph_malloc(const long width, const long height)
     }
     return g;
 }
+
+
+
+// add the crossing weight of a wire to the cost of a node, saturating at UINT8_MAX
+static inline uint8_t add_weight(const uint8_t cost, const uint8_t weight)
+{
+    return cost > UINT8_MAX - weight ? UINT8_MAX : (uint8_t)(cost + weight);
+}
+
+Graph* build_graph(const EndpointRepr* const er)
+{
+    Graph* g = graph_malloc(er->width, er->height);
+    g->width = (uint16_t)er->width;
+    g->height = (uint16_t)er->height;
+    // check if width and height are not too small for new data type
+    assert(((int32_t)g->width == er->width) && ((int32_t)g->height == er->height));
+    g->p1 = (Uint16Point) {(uint16_t)er->p1x, (uint16_t)er->p1y};
+    g->p2 = (Uint16Point) {(uint16_t)er->p2x, (uint16_t)er->p2y};
+    // by default nodes have a cost of 0
+    memset(g->node_cost[0], 0, g->width * g->height * sizeof(uint8_t));
+
+    uint8_t bitmask_all_neighbors = NEIGH_X_NEG | NEIGH_X_POS | NEIGH_Y_NEG | NEIGH_Y_POS;
+    memset(g->neighbors[0], bitmask_all_neighbors, g->width * g->height);
+    // now every node is marked as having all four neighbors. Remove neighbors where this does not apply
+    memset(g->neighbors[0], NEIGH_X_POS | NEIGH_Y_NEG | NEIGH_Y_POS, g->height);
+    memset(g->neighbors[er->width - 1], NEIGH_X_NEG | NEIGH_Y_NEG | NEIGH_Y_POS, g->height);
+    for(int_fast32_t x = 0; x < er->width; x++) {
+        g->neighbors[x][0] &= (uint8_t)~NEIGH_Y_NEG; // unset bit indicating neighbor in negative y direction
+        g->neighbors[x][er->height - 1] &= (uint8_t)~NEIGH_Y_POS;
+    }
+    // remove edges where existing wires are
+    for(int i = 0; i < er->m; i++) {             // for each wire in er
+        const uint8_t weight = er->weights ? er->weights[i] : 1;
+        if(er->wires[i].y1 == er->wires[i].y2) { // horizontal wire in x direction
+            int_fast32_t x1 = er->wires[i].x1;
+            int_fast32_t x2 = er->wires[i].x2;
+            int_fast32_t y = er->wires[i].y1;
+            assert(x1 < x2);
+            g->neighbors[x1][y] &= (uint8_t)~NEIGH_X_POS;                  // no neighbor in positive x direction
+            g->node_cost[x1][y] = add_weight(g->node_cost[x1][y], weight); // increase cost
+            for(int_fast32_t x = x1 + 1; x < x2; x++) {
+                g->neighbors[x][y] &= (uint8_t) ~(NEIGH_X_NEG | NEIGH_X_POS); // no neighbor in +- x direction
+                g->node_cost[x][y] = add_weight(g->node_cost[x][y], weight);  // increase cost
+            }
+            g->neighbors[x2][y] &= (uint8_t)~NEIGH_X_NEG;                  // no neighbor in negative x direction
+            g->node_cost[x2][y] = add_weight(g->node_cost[x2][y], weight); // increase cost
+        }
+        else { // vertical wire in y direction. Basically the same procedure as for horizontal wires
+            assert(er->wires[i].x1 == er->wires[i].x2);
+            int_fast32_t y1 = er->wires[i].y1;
+            int_fast32_t y2 = er->wires[i].y2;
+            int_fast32_t x = er->wires[i].x1;
+            assert(y1 < y2);
+            g->neighbors[x][y1] &= (uint8_t)~NEIGH_Y_POS;
+            g->node_cost[x][y1] = add_weight(g->node_cost[x][y1], weight);
+            for(int_fast32_t y = y1 + 1; y < y2; y++) {
+                g->neighbors[x][y] &= (uint8_t) ~(NEIGH_Y_NEG | NEIGH_Y_POS);
+                g->node_cost[x][y] = add_weight(g->node_cost[x][y], weight);
+            }
+            g->neighbors[x][y2] &= (uint8_t)~NEIGH_Y_NEG;
+            g->node_cost[x][y2] = add_weight(g->node_cost[x][y2], weight);
+        }
+    }
+    return g;
+}
+
+
+
+void graph_add_route(Graph* const g, const Uint16Point* const path, const size_t length, const uint8_t weight)
+{
+    for(size_t i = 0; i < length; i++) {
+        const Uint16Point p = path[i];
+        g->node_cost[p.x][p.y] = add_weight(g->node_cost[p.x][p.y], weight);
+        if(i == 0) {
+            continue;
+        }
+        // remove the edge to the previous node in both directions, like for the segments of a wire
+        const Uint16Point q = path[i - 1];
+        if(q.x < p.x) {
+            g->neighbors[q.x][q.y] &= (uint8_t)~NEIGH_X_POS;
+            g->neighbors[p.x][p.y] &= (uint8_t)~NEIGH_X_NEG;
+        }
+        else if(q.x > p.x) {
+            g->neighbors[q.x][q.y] &= (uint8_t)~NEIGH_X_NEG;
+            g->neighbors[p.x][p.y] &= (uint8_t)~NEIGH_X_POS;
+        }
+        else if(q.y < p.y) {
+            g->neighbors[q.x][q.y] &= (uint8_t)~NEIGH_Y_POS;
+            g->neighbors[p.x][p.y] &= (uint8_t)~NEIGH_Y_NEG;
+        }
+        else {
+            g->neighbors[q.x][q.y] &= (uint8_t)~NEIGH_Y_NEG;
+            g->neighbors[p.x][p.y] &= (uint8_t)~NEIGH_Y_POS;
+        }
+    }
+}
@@ -5,6 +5,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "endpoint_repr.h"
 
 
 typedef struct Uint16Point {
@@ -36,6 +39,14 @@ void print_graph(Graph* const g, bool** path_map);
 // guaranteed to return a valid pointer
 Graph* graph_malloc(const long width, const long height);
 
+// Build a graph based on the reduced EndpointRepr er [see reduce].
+// Guaranteed to return a valid pointer. Caller is responsible for freeing it with graph_free.
+Graph* build_graph(const EndpointRepr* const er);
+
+// Add a routed path to g as if it was a wire: weight is added to the cost of each of its nodes (saturating
+// at UINT8_MAX), and the edges between successive nodes are removed. path must be a path in g.
+void graph_add_route(Graph* const g, const Uint16Point* const path, const size_t length, const uint8_t weight);
+
 // free all internal arrays and the graph itself. Must only be used if graph_malloc was used for
 // allocation, otherwise there could be a memory leak.
 void graph_free(Graph* const g);
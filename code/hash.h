@@ -0,0 +1,29 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define HASH_INIT 0xcbf29ce484222325u // offset basis of the 64 bit FNV-1a hash
+
+
+
+// Continue the 64 bit FNV-1a hash hash with size bytes of data.
+// Start with hash = HASH_INIT. The result depends on the byte order of the machine if data contains
+// multi-byte values.
+static inline uint64_t hash_bytes(uint64_t hash, const void* const data, const size_t size)
+{
+    const unsigned char* bytes = data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3u;
+    }
+    return hash;
+}
+
+
+
+#endif
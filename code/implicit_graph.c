@@ -0,0 +1,160 @@
+#include "implicit_graph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+
+
+// Comparison function for qsort, order intervals by lo
+static int compare_intervals(const void* a, const void* b)
+{
+    const uint16_t x = ((const WireInterval*)a)->lo;
+    const uint16_t y = ((const WireInterval*)b)->lo;
+    return (x > y) - (x < y);
+}
+
+
+
+// Build the index of the horizontal (in rows) or vertical (in columns) wires, with line_count lines.
+// Writes newly allocated arrays to *start and *intervals.
+static void build_index(const EndpointRepr* const er, const bool horizontal, const uint16_t line_count,
+                        uint32_t** start, WireInterval** intervals)
+{
+    *start = calloc((size_t)line_count + 1, sizeof(uint32_t));
+    *intervals = malloc(((size_t)er->m + 1) * sizeof(WireInterval)); // + 1 so it is never malloc(0)
+    if(!*start || !*intervals) {
+        fprintf(stderr, "Allocation for implicit graph index failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    // counting sort by line
+    for(int i = 0; i < er->m; i++) {
+        const Wire w = er->wires[i];
+        if((w.y1 == w.y2) == horizontal) {
+            (*start)[(horizontal ? w.y1 : w.x1) + 1]++;
+        }
+    }
+    for(uint16_t line = 0; line < line_count; line++) {
+        (*start)[line + 1] += (*start)[line];
+    }
+    uint32_t* fill = malloc(((size_t)line_count + 1) * sizeof(uint32_t));
+    if(!fill) {
+        fprintf(stderr, "Allocation for implicit graph index failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(uint16_t line = 0; line < line_count; line++) {
+        fill[line] = (*start)[line];
+    }
+    for(int i = 0; i < er->m; i++) {
+        const Wire w = er->wires[i];
+        if((w.y1 == w.y2) == horizontal) {
+            const uint16_t line = (uint16_t)(horizontal ? w.y1 : w.x1);
+            (*intervals)[fill[line]++] = (WireInterval) {.lo = (uint16_t)(horizontal ? w.x1 : w.y1),
+                                                         .hi = (uint16_t)(horizontal ? w.x2 : w.y2)};
+        }
+    }
+    free(fill);
+    // sort every line and compute the running maxima
+    for(uint16_t line = 0; line < line_count; line++) {
+        WireInterval* first = *intervals + (*start)[line];
+        const size_t n = (*start)[line + 1] - (*start)[line];
+        qsort(first, n, sizeof(WireInterval), compare_intervals);
+        uint16_t max_hi = 0;
+        for(size_t i = 0; i < n; i++) {
+            max_hi = first[i].hi > max_hi ? first[i].hi : max_hi;
+            first[i].max_hi = max_hi;
+        }
+    }
+}
+
+
+
+ImplicitGraph* implicit_graph_new(const EndpointRepr* const er)
+{
+    ImplicitGraph* ig = malloc(sizeof(ImplicitGraph));
+    if(!ig) {
+        fprintf(stderr, "Allocation for ImplicitGraph failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    ig->width = (uint16_t)er->width;
+    ig->height = (uint16_t)er->height;
+    // check if width and height are not too small for new data type
+    assert(((int32_t)ig->width == er->width) && ((int32_t)ig->height == er->height));
+    ig->p1 = (Uint16Point) {(uint16_t)er->p1x, (uint16_t)er->p1y};
+    ig->p2 = (Uint16Point) {(uint16_t)er->p2x, (uint16_t)er->p2y};
+    build_index(er, true, ig->height, &ig->row_start, &ig->row_intervals);
+    build_index(er, false, ig->width, &ig->col_start, &ig->col_intervals);
+    return ig;
+}
+
+
+
+void implicit_graph_free(ImplicitGraph* ig)
+{
+    free(ig->row_start);
+    free(ig->row_intervals);
+    free(ig->col_start);
+    free(ig->col_intervals);
+    free(ig);
+}
+
+
+
+// Count the intervals of a line that cover all nodes from lo to hi.
+static unsigned count_covering(const WireInterval* intervals, const uint32_t begin, const uint32_t end,
+                               const uint16_t lo, const uint16_t hi)
+{
+    // binary search for the first interval that starts after lo
+    uint32_t left = begin;
+    uint32_t right = end;
+    while(left < right) {
+        const uint32_t mid = left + (right - left) / 2;
+        if(intervals[mid].lo <= lo) {
+            left = mid + 1;
+        }
+        else {
+            right = mid;
+        }
+    }
+    // all intervals before it start at or before lo, walk back as long as any of them can reach hi
+    unsigned count = 0;
+    for(uint32_t i = left; i > begin && intervals[i - 1].max_hi >= hi; i--) {
+        count += intervals[i - 1].hi >= hi;
+    }
+    return count;
+}
+
+
+
+uint8_t implicit_node_cost(const ImplicitGraph* const ig, const Uint16Point p)
+{
+    const unsigned cost = count_covering(ig->row_intervals, ig->row_start[p.y], ig->row_start[p.y + 1], p.x, p.x) +
+                          count_covering(ig->col_intervals, ig->col_start[p.x], ig->col_start[p.x + 1], p.y, p.y);
+    return (uint8_t)cost;
+}
+
+
+
+uint8_t implicit_neighbors(const ImplicitGraph* const ig, const Uint16Point p)
+{
+    uint8_t neighbors = 0;
+    // a move is possible if it stays within the grid and does not go along a wire
+    const uint32_t row_begin = ig->row_start[p.y];
+    const uint32_t row_end = ig->row_start[p.y + 1];
+    const uint32_t col_begin = ig->col_start[p.x];
+    const uint32_t col_end = ig->col_start[p.x + 1];
+    if(p.x + 1 < ig->width && !count_covering(ig->row_intervals, row_begin, row_end, p.x, p.x + 1)) {
+        neighbors |= NEIGH_X_POS;
+    }
+    if(p.x > 0 && !count_covering(ig->row_intervals, row_begin, row_end, p.x - 1, p.x)) {
+        neighbors |= NEIGH_X_NEG;
+    }
+    if(p.y + 1 < ig->height && !count_covering(ig->col_intervals, col_begin, col_end, p.y, p.y + 1)) {
+        neighbors |= NEIGH_Y_POS;
+    }
+    if(p.y > 0 && !count_covering(ig->col_intervals, col_begin, col_end, p.y - 1, p.y)) {
+        neighbors |= NEIGH_Y_NEG;
+    }
+    return neighbors;
+}
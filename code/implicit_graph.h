@@ -0,0 +1,59 @@
+#ifndef _IMPLICIT_GRAPH_H
+#define _IMPLICIT_GRAPH_H
+
+
+/*
+ * Implicit graph
+ *
+ * Instead of materializing node_cost and neighbors for every node like build_graph does, the implicit
+ * graph only stores the wires of the reduced EndpointRepr, indexed by the row (horizontal wires) or
+ * column (vertical wires) they lie in. The cost and the neighbors of a node are computed on demand with
+ * a binary search in the intervals of its row and column. Memory is O(m + width + height), and since
+ * width and height are O(m) after the reduction, O(m).
+ */
+
+
+
+#include <stdint.h>
+
+#include "graph.h"
+#include "endpoint_repr.h"
+
+
+
+// a wire within its row or column, covering the nodes lo..hi
+typedef struct WireInterval {
+    uint16_t lo;
+    uint16_t hi;
+    uint16_t max_hi; // maximum of hi over this and all previous intervals in the same line
+} WireInterval;
+
+typedef struct ImplicitGraph {
+    uint16_t width;
+    uint16_t height;
+    Uint16Point p1; // coordinates of the start and end points
+    Uint16Point p2;
+    // intervals of the horizontal wires in row y are row_intervals[row_start[y]] to
+    // row_intervals[row_start[y + 1] - 1], sorted by lo. Likewise for the vertical wires in column x.
+    uint32_t* row_start;
+    WireInterval* row_intervals;
+    uint32_t* col_start;
+    WireInterval* col_intervals;
+} ImplicitGraph;
+
+
+
+// Build the implicit graph for the reduced EndpointRepr er.
+// Guaranteed to return a valid pointer. Caller is responsible for freeing it with implicit_graph_free.
+ImplicitGraph* implicit_graph_new(const EndpointRepr* const er);
+void implicit_graph_free(ImplicitGraph* ig);
+
+// Same value as node_cost[p.x][p.y] of the graph built from the same EndpointRepr.
+uint8_t implicit_node_cost(const ImplicitGraph* const ig, const Uint16Point p);
+
+// Same value as neighbors[p.x][p.y] of the graph built from the same EndpointRepr.
+uint8_t implicit_neighbors(const ImplicitGraph* const ig, const Uint16Point p);
+
+
+
+#endif
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L // for mmap, fstat, open
+
+#include "instance_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+#define MAGIC                "WIRASBIN"
+#define MAGIC_SIZE           8
+#define FILE_HEADER_SIZE     32
+#define INSTANCE_HEADER_SIZE 24 // 6 int32
+#define WIRE_SIZE            16 // 4 int32
+
+
+static_assert(sizeof(Wire) == WIRE_SIZE, "Wire must be packed to be usable directly on the mapped file");
+
+
+
+struct InstanceWriter {
+    FILE* file;
+    uint64_t* offsets; // offset of every instance written so far
+    uint64_t n;
+    uint64_t allocated_n;
+    uint64_t position; // current write position in bytes
+    bool failed;       // true if any write failed
+};
+
+struct InstanceFile {
+    void* base; // start of the mapping
+    size_t size;
+    uint64_t instance_count;
+    uint64_t index_offset;
+};
+
+
+
+static inline void put_le32(uint8_t* const buf, const uint32_t v)
+{
+    buf[0] = (uint8_t)v;
+    buf[1] = (uint8_t)(v >> 8);
+    buf[2] = (uint8_t)(v >> 16);
+    buf[3] = (uint8_t)(v >> 24);
+}
+
+static inline void put_le64(uint8_t* const buf, const uint64_t v)
+{
+    put_le32(buf, (uint32_t)v);
+    put_le32(buf + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint32_t get_le32(const uint8_t* const buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static inline uint64_t get_le64(const uint8_t* const buf)
+{
+    return (uint64_t)get_le32(buf) | ((uint64_t)get_le32(buf + 4) << 32);
+}
+
+
+
+static void writer_write(InstanceWriter* w, const void* const data, const size_t size)
+{
+    if(fwrite(data, 1, size, w->file) != size) {
+        w->failed = true;
+    }
+    w->position += size;
+}
+
+
+
+InstanceWriter* instance_writer_open(const char* path)
+{
+    InstanceWriter* w = malloc(sizeof(InstanceWriter));
+    if(!w) {
+        fprintf(stderr, "Allocation for InstanceWriter failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    w->file = fopen(path, "wb");
+    if(!w->file) {
+        free(w);
+        return NULL;
+    }
+    w->n = 0;
+    w->allocated_n = 64;
+    w->offsets = malloc(w->allocated_n * sizeof(uint64_t));
+    if(!w->offsets) {
+        fprintf(stderr, "Allocation for instance index failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    w->position = 0;
+    w->failed = false;
+    // placeholder, the real header is written by instance_writer_close once the index offset is known
+    uint8_t header[FILE_HEADER_SIZE] = {0};
+    writer_write(w, header, sizeof(header));
+    return w;
+}
+
+
+
+void instance_writer_add(InstanceWriter* w, const EndpointRepr* const er)
+{
+    assert(w && er && er->m >= 0);
+    if(w->n == w->allocated_n) {
+        uint64_t* new_ptr = realloc(w->offsets, 2 * w->allocated_n * sizeof(uint64_t));
+        if(!new_ptr) {
+            fprintf(stderr, "Reallocating instance index failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        w->offsets = new_ptr;
+        w->allocated_n *= 2;
+    }
+    w->offsets[w->n++] = w->position; // always a multiple of 4
+
+    uint8_t header[INSTANCE_HEADER_SIZE];
+    put_le32(header, (uint32_t)er->m);
+    put_le32(header + 4, (uint32_t)er->width);
+    put_le32(header + 8, (uint32_t)er->p1x);
+    put_le32(header + 12, (uint32_t)er->p1y);
+    put_le32(header + 16, (uint32_t)er->p2x);
+    put_le32(header + 20, (uint32_t)er->p2y);
+    writer_write(w, header, sizeof(header));
+    for(int i = 0; i < er->m; i++) {
+        uint8_t wire[WIRE_SIZE];
+        put_le32(wire, (uint32_t)er->wires[i].x1);
+        put_le32(wire + 4, (uint32_t)er->wires[i].y1);
+        put_le32(wire + 8, (uint32_t)er->wires[i].x2);
+        put_le32(wire + 12, (uint32_t)er->wires[i].y2);
+        writer_write(w, wire, sizeof(wire));
+    }
+}
+
+
+
+bool instance_writer_close(InstanceWriter* w)
+{
+    // align the index to 8 bytes
+    const uint8_t padding[8] = {0};
+    writer_write(w, padding, (8 - w->position % 8) % 8);
+    const uint64_t index_offset = w->position;
+    for(uint64_t i = 0; i < w->n; i++) {
+        uint8_t entry[8];
+        put_le64(entry, w->offsets[i]);
+        writer_write(w, entry, sizeof(entry));
+    }
+
+    uint8_t header[FILE_HEADER_SIZE] = {0};
+    memcpy(header, MAGIC, MAGIC_SIZE);
+    put_le32(header + 8, INSTANCE_FILE_VERSION);
+    put_le64(header + 16, w->n);
+    put_le64(header + 24, index_offset);
+    if(fseek(w->file, 0, SEEK_SET) != 0) {
+        w->failed = true;
+    }
+    writer_write(w, header, sizeof(header));
+
+    bool success = !w->failed;
+    if(fclose(w->file) != 0) {
+        success = false;
+    }
+    free(w->offsets);
+    free(w);
+    return success;
+}
+
+
+
+InstanceFile* instance_file_map(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Opening instance file '%s' failed.\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < FILE_HEADER_SIZE) {
+        fprintf(stderr, "Instance file '%s' is too small to be valid.\n", path);
+        close(fd);
+        return NULL;
+    }
+    const size_t size = (size_t)st.st_size;
+    // Private writable mapping: the solver reduces the wires in place, which copies only the touched
+    // pages and never writes back to the file.
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if(base == MAP_FAILED) {
+        fprintf(stderr, "Mapping instance file '%s' failed.\n", path);
+        return NULL;
+    }
+
+    const uint8_t* header = base;
+    const uint64_t instance_count = get_le64(header + 16);
+    const uint64_t index_offset = get_le64(header + 24);
+    if(memcmp(header, MAGIC, MAGIC_SIZE) != 0 || get_le32(header + 8) != INSTANCE_FILE_VERSION ||
+       index_offset % 8 != 0 || index_offset < FILE_HEADER_SIZE || index_offset > size ||
+       instance_count > (size - index_offset) / 8) {
+        fprintf(stderr, "'%s' is not a valid instance file (version %d).\n", path, INSTANCE_FILE_VERSION);
+        munmap(base, size);
+        return NULL;
+    }
+
+    InstanceFile* f = malloc(sizeof(InstanceFile));
+    if(!f) {
+        fprintf(stderr, "Allocation for InstanceFile failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    f->base = base;
+    f->size = size;
+    f->instance_count = instance_count;
+    f->index_offset = index_offset;
+    return f;
+}
+
+
+
+uint64_t instance_file_count(const InstanceFile* f)
+{
+    return f->instance_count;
+}
+
+
+
+void instance_file_get(InstanceFile* f, const uint64_t index, EndpointRepr* const er)
+{
+    assert(f && er && index < f->instance_count);
+    const uint8_t* bytes = f->base;
+    const uint64_t offset = get_le64(bytes + f->index_offset + 8 * index);
+    // instance_file_map guarantees index_offset >= FILE_HEADER_SIZE, check the bounds before subtracting
+    if(offset % 4 != 0 || offset < FILE_HEADER_SIZE || offset > f->index_offset ||
+       f->index_offset - offset < INSTANCE_HEADER_SIZE) {
+        fprintf(stderr, "Instance file index entry %lu is corrupt.\n", (unsigned long)index);
+        exit(EXIT_FAILURE);
+    }
+    const uint8_t* header = bytes + offset;
+    er->m = (int)(int32_t)get_le32(header);
+    er->width = (int32_t)get_le32(header + 4);
+    er->height = er->width;
+    er->p1x = (int32_t)get_le32(header + 8);
+    er->p1y = (int32_t)get_le32(header + 12);
+    er->p2x = (int32_t)get_le32(header + 16);
+    er->p2y = (int32_t)get_le32(header + 20);
+    if(er->m < 0 || (uint64_t)er->m > (f->index_offset - offset - INSTANCE_HEADER_SIZE) / WIRE_SIZE) {
+        fprintf(stderr, "Instance %lu in instance file is corrupt.\n", (unsigned long)index);
+        exit(EXIT_FAILURE);
+    }
+    // the wires are used directly from the mapping, no copy
+    er->wires = (void*)((char*)f->base + offset + INSTANCE_HEADER_SIZE);
+    er->weights = NULL; // the binary format has no crossing weights
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    // convert the wires in place, the mapping is private so the file stays little-endian
+    int32_t* coords = (int32_t*)er->wires;
+    for(int i = 0; i < 4 * er->m; i++) {
+        coords[i] = (int32_t)get_le32((const uint8_t*)&coords[i]);
+    }
+#endif
+}
+
+
+
+void instance_file_unmap(InstanceFile* f)
+{
+    munmap(f->base, f->size);
+    free(f);
+}
@@ -0,0 +1,75 @@
+#ifndef _INSTANCE_FILE_H
+#define _INSTANCE_FILE_H
+
+
+/*
+ * Binary instance format
+ *
+ * Parsing the text format costs far more than the size of the data justifies for large batches,
+ * so instances can be converted once into a compact binary file which can then be memory mapped
+ * and solved without any parsing or copying. All integers are little-endian.
+ *
+ *   file header (32 bytes)
+ *     char     magic[8]          "WIRASBIN"
+ *     uint32   version           INSTANCE_FILE_VERSION
+ *     uint32   reserved          0
+ *     uint64   instance_count
+ *     uint64   index_offset      byte offset of the instance index
+ *   instances, each starting at an offset that is a multiple of 4
+ *     int32    m, size, p1x, p1y, p2x, p2y
+ *     int32    wires[m][4]       x1 y1 x2 y2 for each wire, same layout as an array of Wire
+ *   instance index, starting at an offset that is a multiple of 8
+ *     uint64   offsets[instance_count]   byte offset of each instance
+ *
+ * The index makes it possible to jump straight to instance N, e.g. to split a batch between
+ * several processes.
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+
+
+#define INSTANCE_FILE_VERSION 1
+
+
+
+typedef struct InstanceWriter InstanceWriter;
+typedef struct InstanceFile InstanceFile;
+
+
+// Create (or truncate) the file at path and prepare it for appending instances.
+// Returns NULL if the file could not be opened.
+InstanceWriter* instance_writer_open(const char* path);
+
+// Append the instance er to the file. er must not have been reduced yet.
+void instance_writer_add(InstanceWriter* w, const EndpointRepr* const er);
+
+// Write the index and the header, close the file and free w.
+// Returns false if writing failed, in which case the file must be considered corrupt.
+bool instance_writer_close(InstanceWriter* w);
+
+
+// Memory map the binary instance file at path.
+// Returns NULL if the file could not be mapped or is not a valid instance file.
+// Caller is responsible for unmapping it with instance_file_unmap.
+InstanceFile* instance_file_map(const char* path);
+
+// number of instances in the file
+uint64_t instance_file_count(const InstanceFile* f);
+
+// Point er to the instance with the given index (0 <= index < instance_file_count(f)).
+// er->wires will point directly into the mapping. It may be modified (e.g. by reduce), which does
+// not change the file, but it must not be freed and is only valid until instance_file_unmap is called.
+// Modifications persist until the file is unmapped, so each instance should only be retrieved once.
+void instance_file_get(InstanceFile* f, const uint64_t index, EndpointRepr* const er);
+
+// Unmap the file and free f.
+void instance_file_unmap(InstanceFile* f);
+
+
+
+#endif
@@ -0,0 +1,81 @@
+#include "instance_gen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+
+
+uint64_t gen_next(GenRng* rng)
+{
+    uint64_t z = (rng->state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+
+
+uint32_t gen_below(GenRng* rng, const uint32_t bound)
+{
+    assert(bound > 0);
+    return (uint32_t)(gen_next(rng) % bound); // the modulo bias is negligible for 32 bit bounds
+}
+
+
+
+void gen_instance(EndpointRepr* const er, GenRng* rng, const int m, const int32_t size)
+{
+    assert(m >= 0 && size >= 2);
+    er->m = m;
+    er->width = size;
+    er->height = size;
+    er->weights = NULL;
+    er->wires = malloc(((size_t)m + 1) * sizeof(Wire)); // + 1 so it is never malloc(0)
+    if(!er->wires) {
+        fprintf(stderr, "Allocation for generated wires failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    const uint32_t usize = (uint32_t)size;
+    for(int i = 0; i < m; i++) {
+        // a line index and two different positions within the line
+        const int32_t line = (int32_t)gen_below(rng, usize);
+        const int32_t lo = (int32_t)gen_below(rng, usize - 1);
+        const int32_t hi = lo + 1 + (int32_t)gen_below(rng, usize - 1 - (uint32_t)lo);
+        if(gen_next(rng) & 1) {
+            er->wires[i] = (Wire) {.x1 = lo, .y1 = line, .x2 = hi, .y2 = line};
+        }
+        else {
+            er->wires[i] = (Wire) {.x1 = line, .y1 = lo, .x2 = line, .y2 = hi};
+        }
+    }
+    er->p1x = (int32_t)gen_below(rng, usize);
+    er->p1y = (int32_t)gen_below(rng, usize);
+    er->p2x = (int32_t)gen_below(rng, usize);
+    er->p2y = (int32_t)gen_below(rng, usize);
+}
+
+
+
+void gen_comb_instance(EndpointRepr* const er, GenRng* rng, const int m, const int32_t size)
+{
+    assert(m >= 1 && size >= m + 2);
+    er->m = m;
+    er->width = size;
+    er->height = size;
+    er->weights = NULL;
+    er->wires = malloc((size_t)m * sizeof(Wire));
+    if(!er->wires) {
+        fprintf(stderr, "Allocation for generated wires failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < m; i++) {
+        const int32_t x = 1 + (int32_t)((int64_t)i * (size - 2) / m);
+        const int32_t bottom = i % 2; // the gap is at the top for even i, at the bottom for odd i
+        er->wires[i] = (Wire) {.x1 = x, .y1 = bottom, .x2 = x, .y2 = size - 2 + bottom};
+    }
+    er->p1x = 0;
+    er->p1y = (int32_t)gen_below(rng, (uint32_t)size);
+    er->p2x = size - 1;
+    er->p2y = (int32_t)gen_below(rng, (uint32_t)size);
+}
@@ -0,0 +1,44 @@
+#ifndef _INSTANCE_GEN_H
+#define _INSTANCE_GEN_H
+
+
+/*
+ * Random problem instances
+ *
+ * Deterministic generator for the development tools (microbenchmarks, fuzzing) and the calibration run
+ * of the engine selection [see portfolio.h], so that a run can be repeated with the same seed.
+ */
+
+
+
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+
+
+
+// state of the pseudo random number generator (splitmix64), any value is a valid seed
+typedef struct GenRng {
+    uint64_t state;
+} GenRng;
+
+// next pseudo random 64 bit value
+uint64_t gen_next(GenRng* rng);
+
+// pseudo random value in [0, bound), bound must be > 0
+uint32_t gen_below(GenRng* rng, const uint32_t bound);
+
+// Fill er with a random unreduced instance with m wires on a size x size grid (size >= 2). Every wire
+// is horizontal or vertical with random end points, and so are the points to connect.
+// er->wires is newly allocated, the caller is responsible for freeing it.
+void gen_instance(EndpointRepr* const er, GenRng* rng, const int m, const int32_t size);
+
+// Fill er with a comb of m vertical wires spread over a size x size grid (size >= m + 2), attached
+// alternately to the bottom and the top row, with the points to connect left of the first wire and right
+// of the last one. The cheapest path has no intersections, but it has to wind around every wire.
+// er->wires is newly allocated, the caller is responsible for freeing it.
+void gen_comb_instance(EndpointRepr* const er, GenRng* rng, const int m, const int32_t size);
+
+
+
+#endif
@@ -0,0 +1,300 @@
+#include "landmarks.h"
+#include "hash.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+#define LANDMARK_MAGIC      "WIRASLMK"
+#define LANDMARK_MAGIC_SIZE 8
+#define LANDMARK_VERSION    2
+
+
+
+// the landmark set used by landmark_heuristic and the graph it belongs to [see landmarks_activate]
+static const LandmarkSet* active_set = NULL;
+static const Graph* active_graph = NULL;
+// active_columns[x] is the column of the landmark graph that column x of active_graph stands for, likewise
+// active_rows
+static uint16_t* active_columns = NULL;
+static uint16_t* active_rows = NULL;
+
+
+
+static inline bool is_infinite(const PathMetric m)
+{
+    return m.intersections == UINT16_MAX;
+}
+
+
+
+static uint64_t board_fingerprint(const EndpointRepr* const er)
+{
+    const bool weighted = er->weights != NULL;
+    uint64_t hash = hash_bytes(HASH_INIT, &er->width, sizeof(er->width));
+    hash = hash_bytes(hash, &er->height, sizeof(er->height));
+    hash = hash_bytes(hash, &er->m, sizeof(er->m));
+    hash = hash_bytes(hash, er->wires, (size_t)er->m * sizeof(Wire));
+    hash = hash_bytes(hash, &weighted, sizeof(weighted));
+    return weighted ? hash_bytes(hash, er->weights, (size_t)er->m) : hash;
+}
+
+
+
+// allocate a LandmarkSet with uninitialized tables
+static LandmarkSet* landmarks_alloc(const uint16_t width, const uint16_t height, const unsigned count)
+{
+    LandmarkSet* ls = malloc(sizeof(LandmarkSet));
+    if(!ls) {
+        fprintf(stderr, "Allocation for LandmarkSet failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    ls->width = width;
+    ls->height = height;
+    ls->count = count;
+    ls->landmarks = malloc(count * sizeof(Uint16Point));
+    ls->dist = malloc((size_t)count * width * height * sizeof(PathMetric));
+    ls->x_coords = malloc(width * sizeof(int32_t));
+    ls->y_coords = malloc(height * sizeof(int32_t));
+    if(!ls->landmarks || !ls->dist || !ls->x_coords || !ls->y_coords) {
+        fprintf(stderr, "Allocation for landmark tables failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ls;
+}
+
+
+
+// index of the node with the lexicographically greatest finite metric in dist
+static size_t farthest_node(const PathMetric* dist, const size_t node_count)
+{
+    size_t farthest = 0;
+    for(size_t i = 1; i < node_count; i++) {
+        if(!is_infinite(dist[i]) && (is_infinite(dist[farthest]) || cheaper_path(dist[farthest], dist[i]))) {
+            farthest = i;
+        }
+    }
+    return farthest;
+}
+
+
+
+LandmarkSet* landmarks_compute(const EndpointRepr* const er, const unsigned count)
+{
+    assert(count > 0 && er->m > 0);
+    // reduce a copy without the endpoints, which are put on the start of the first wire, so they add no line
+    EndpointRepr board = *er;
+    board.wires = malloc((size_t)er->m * sizeof(Wire));
+    if(!board.wires) {
+        fprintf(stderr, "Allocation for landmark graph failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(board.wires, er->wires, (size_t)er->m * sizeof(Wire));
+    board.p1x = board.p2x = board.wires[0].x1;
+    board.p1y = board.p2y = board.wires[0].y1;
+    int32_t* x_coords;
+    int32_t* y_coords;
+    reduce_with_points(&board, NULL, NULL, 0, 1, &x_coords, &y_coords);
+    Graph* g = build_graph(&board);
+
+    const size_t node_count = (size_t)g->width * g->height;
+    LandmarkSet* ls = landmarks_alloc(g->width, g->height, count);
+    ls->fingerprint = board_fingerprint(er);
+    memcpy(ls->x_coords, x_coords, g->width * sizeof(int32_t));
+    memcpy(ls->y_coords, y_coords, g->height * sizeof(int32_t));
+    free(x_coords);
+    free(y_coords);
+
+    // Farthest point selection: start with the node farthest from the corner, then always choose the
+    // node with the greatest distance to its closest landmark.
+    PathMetric* min_dist = malloc(node_count * sizeof(PathMetric));
+    if(!min_dist) {
+        fprintf(stderr, "Allocation for landmark selection failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    shortest_path_metrics(g, (Uint16Point) {0, 0}, min_dist);
+    for(unsigned i = 0; i < count; i++) {
+        const size_t farthest = farthest_node(min_dist, node_count);
+        const Uint16Point landmark = {(uint16_t)(farthest / g->height), (uint16_t)(farthest % g->height)};
+        ls->landmarks[i] = landmark;
+        PathMetric* dist = ls->dist + i * node_count;
+        shortest_path_metrics(g, landmark, dist);
+        for(size_t v = 0; v < node_count; v++) {
+            if(i == 0 || cheaper_path(dist[v], min_dist[v])) {
+                min_dist[v] = dist[v];
+            }
+        }
+    }
+    free(min_dist);
+    graph_free(g);
+    free(board.wires);
+    return ls;
+}
+
+
+
+void landmarks_free(LandmarkSet* ls)
+{
+    if(active_set == ls) {
+        active_set = NULL;
+        active_graph = NULL;
+        free(active_columns);
+        free(active_rows);
+        active_columns = NULL;
+        active_rows = NULL;
+    }
+    free(ls->landmarks);
+    free(ls->dist);
+    free(ls->x_coords);
+    free(ls->y_coords);
+    free(ls);
+}
+
+
+
+bool landmarks_match(const LandmarkSet* const ls, const EndpointRepr* const er)
+{
+    return ls->fingerprint == board_fingerprint(er);
+}
+
+
+
+// File format: magic, uint32 version, uint16 width, uint16 height, uint64 fingerprint, uint32 count,
+// Uint16Point landmarks[count], PathMetric dist[count * width * height], int32 x_coords[width],
+// int32 y_coords[height]
+LandmarkSet* landmarks_load(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        return NULL;
+    }
+    char magic[LANDMARK_MAGIC_SIZE];
+    uint32_t version;
+    uint16_t width, height;
+    uint64_t fingerprint;
+    uint32_t count;
+    if(fread(magic, 1, LANDMARK_MAGIC_SIZE, file) != LANDMARK_MAGIC_SIZE ||
+       memcmp(magic, LANDMARK_MAGIC, LANDMARK_MAGIC_SIZE) != 0 || fread(&version, sizeof(version), 1, file) != 1 ||
+       version != LANDMARK_VERSION || fread(&width, sizeof(width), 1, file) != 1 ||
+       fread(&height, sizeof(height), 1, file) != 1 || fread(&fingerprint, sizeof(fingerprint), 1, file) != 1 ||
+       fread(&count, sizeof(count), 1, file) != 1 || count == 0 || count > 1024) {
+        fclose(file);
+        return NULL;
+    }
+    LandmarkSet* ls = landmarks_alloc(width, height, count);
+    ls->fingerprint = fingerprint;
+    const size_t table_size = (size_t)count * width * height;
+    if(fread(ls->landmarks, sizeof(Uint16Point), count, file) != count ||
+       fread(ls->dist, sizeof(PathMetric), table_size, file) != table_size ||
+       fread(ls->x_coords, sizeof(int32_t), width, file) != width ||
+       fread(ls->y_coords, sizeof(int32_t), height, file) != height) {
+        fclose(file);
+        landmarks_free(ls);
+        return NULL;
+    }
+    fclose(file);
+    return ls;
+}
+
+
+
+bool landmarks_save(const LandmarkSet* const ls, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    const uint32_t version = LANDMARK_VERSION;
+    const uint32_t count = ls->count;
+    const size_t table_size = (size_t)count * ls->width * ls->height;
+    bool ok = fwrite(LANDMARK_MAGIC, 1, LANDMARK_MAGIC_SIZE, file) == LANDMARK_MAGIC_SIZE &&
+              fwrite(&version, sizeof(version), 1, file) == 1 && fwrite(&ls->width, sizeof(ls->width), 1, file) == 1 &&
+              fwrite(&ls->height, sizeof(ls->height), 1, file) == 1 &&
+              fwrite(&ls->fingerprint, sizeof(ls->fingerprint), 1, file) == 1 &&
+              fwrite(&count, sizeof(count), 1, file) == 1 &&
+              fwrite(ls->landmarks, sizeof(Uint16Point), count, file) == count &&
+              fwrite(ls->dist, sizeof(PathMetric), table_size, file) == table_size &&
+              fwrite(ls->x_coords, sizeof(int32_t), ls->width, file) == ls->width &&
+              fwrite(ls->y_coords, sizeof(int32_t), ls->height, file) == ls->height;
+    if(fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+
+
+// Write the line of the landmark graph that each of the size lines of a query graph, mapped to the board
+// by coords, stands for to lines. That is the last line of the landmark graph starting at or before it.
+static void map_lines(const int32_t* const coords, const uint16_t size, const int32_t* const landmark_coords,
+                      const uint16_t landmark_size, uint16_t* lines)
+{
+    uint16_t line = 0;
+    for(uint16_t i = 0; i < size; i++) { // both coords are increasing
+        while(line + 1 < landmark_size && landmark_coords[line + 1] <= coords[i]) {
+            line++;
+        }
+        lines[i] = line;
+    }
+}
+
+void landmarks_activate(const LandmarkSet* const ls, const Graph* const g, const int32_t* const x_coords,
+                        const int32_t* const y_coords)
+{
+    active_set = ls;
+    active_graph = g;
+    active_columns = realloc(active_columns, g->width * sizeof(uint16_t));
+    active_rows = realloc(active_rows, g->height * sizeof(uint16_t));
+    if(!active_columns || !active_rows) {
+        fprintf(stderr, "Allocation for landmark line maps failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    map_lines(x_coords, g->width, ls->x_coords, ls->width, active_columns);
+    map_lines(y_coords, g->height, ls->y_coords, ls->height, active_rows);
+}
+
+
+
+PathMetric landmark_heuristic(const Uint16Point p, const Uint16Point goal)
+{
+    assert(active_set && active_graph);
+    const uint16_t manhattan = manhattan_distance(p, goal).length;
+    const size_t node_count = (size_t)active_set->width * active_set->height;
+    const size_t p_id = (size_t)active_columns[p.x] * active_set->height + active_rows[p.y];
+    const size_t goal_id = (size_t)active_columns[goal.x] * active_set->height + active_rows[goal.y];
+    const int32_t p_cost = active_graph->node_cost[p.x][p.y];
+    const int32_t goal_cost = active_graph->node_cost[goal.x][goal.y];
+
+    // Every candidate (i, l) is a lexicographic lower bound in the landmark graph, and so in the graph of the
+    // query, which has the same intersections and more lines. If i >= 0, the length can be raised to the
+    // manhattan distance, which is a lower bound for the length of any path.
+    int32_t best_i = 0;
+    int32_t best_l = manhattan;
+    for(unsigned k = 0; k < active_set->count; k++) {
+        const PathMetric to_p = active_set->dist[k * node_count + p_id];
+        const PathMetric to_goal = active_set->dist[k * node_count + goal_id];
+        if(is_infinite(to_p) || is_infinite(to_goal)) {
+            continue;
+        }
+        // forward: d(p, goal) >= d(L, goal) - d(L, p)
+        // backward: d(p, goal) >= d(p, L) - d(goal, L), where d(v, L) = d(L, v) - cost(v) + cost(L)
+        // since the cost of the start node is not counted, but the cost of the last node is.
+        const int32_t candidates[2][2] = {
+            {(int32_t)to_goal.intersections - to_p.intersections, (int32_t)to_goal.length - to_p.length},
+            {((int32_t)to_p.intersections - p_cost) - ((int32_t)to_goal.intersections - goal_cost),
+             (int32_t)to_p.length - to_goal.length}};
+        for(int c = 0; c < 2; c++) {
+            const int32_t i = candidates[c][0];
+            const int32_t l = candidates[c][1] > manhattan ? candidates[c][1] : manhattan;
+            if(i > best_i || (i == best_i && l > best_l)) {
+                best_i = i;
+                best_l = l;
+            }
+        }
+    }
+    return (PathMetric) {(uint16_t)best_i, (uint16_t)best_l};
+}
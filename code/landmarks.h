@@ -0,0 +1,71 @@
+#ifndef _LANDMARKS_H
+#define _LANDMARKS_H
+
+
+/*
+ * Landmark (ALT) heuristic
+ *
+ * manhattan_distance ignores the wires entirely, so it is a poor guide for the number of intersections.
+ * For repeated queries on the same board, a few landmarks can be chosen on the graph and the exact
+ * path metrics from each landmark to every node can be stored. By the triangle inequality, these give a
+ * lower bound for the metric of the cheapest path from any node to the goal, including the intersections.
+ * The tables are computed on the board reduced without the endpoints, so they only depend on the wires and
+ * can be reused for any pair of endpoints on the same board, and saved and loaded again to pay their cost
+ * only once. The graph of a query, reduced with its endpoints, keeps every line of that graph and some free
+ * lines more, so each of its lines stands for exactly one line of the landmark graph, where the distances
+ * are looked up.
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+#include "a_star.h"
+
+
+
+typedef struct LandmarkSet {
+    uint16_t width;       // of the landmark graph, the board reduced without its endpoints
+    uint16_t height;
+    uint64_t fingerprint; // hash of the size, wires and weights of the unreduced board
+    unsigned count;       // number of landmarks
+    Uint16Point* landmarks;
+    PathMetric* dist;  // dist[i * width * height + x * height + y]: cheapest path from landmark i to (x, y)
+    int32_t* x_coords; // x_coords[x] is the first column of the board that column x stands for, likewise y_coords
+    int32_t* y_coords;
+} LandmarkSet;
+
+
+
+// Reduce the board of er (which is not changed) without its endpoints, choose count landmarks on its graph
+// (each one as far as possible from the previous ones) and calculate their tables.
+// Guaranteed to return a valid pointer. Caller is responsible for freeing it with landmarks_free.
+LandmarkSet* landmarks_compute(const EndpointRepr* const er, const unsigned count);
+void landmarks_free(LandmarkSet* ls);
+
+// Returns true iff the tables of ls belong to the unreduced board of er, i.e. it has the same size, wires
+// and weights as the board they were computed on. The endpoints may differ.
+bool landmarks_match(const LandmarkSet* const ls, const EndpointRepr* const er);
+
+// Load a landmark file. Returns NULL if it does not exist or is not a valid landmark file.
+// Landmark files are written in the byte order of the machine and are not meant to be portable.
+LandmarkSet* landmarks_load(const char* path);
+
+// Save ls to a landmark file. Returns false if writing failed.
+bool landmarks_save(const LandmarkSet* const ls, const char* path);
+
+// Use ls for all following calls of landmark_heuristic on g, the graph of a board that matches ls, reduced
+// with any endpoints. x_coords and y_coords map the lines of g to the board [see reduce_with_points].
+// The heuristic function type has no context parameter, so this has to be global state.
+void landmarks_activate(const LandmarkSet* const ls, const Graph* const g, const int32_t* const x_coords,
+                        const int32_t* const y_coords);
+
+// HeuristicFunc based on the activated landmarks, combined with the manhattan distance.
+PathMetric landmark_heuristic(const Uint16Point p, const Uint16Point goal);
+
+
+
+#endif
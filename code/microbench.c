@@ -0,0 +1,634 @@
+/*
+ * Microbenchmarks for the individual components
+ *
+ * Every benchmark runs a number of warm-up samples and then the measured samples, and prints the minimum,
+ * median, mean and standard deviation of the time per operation. The inputs are generated with a fixed
+ * seed, so two builds can be compared on exactly the same data. Before the search variants are timed,
+ * they are checked to return the same results, and the priority queue is checked against a simple
+ * reference implementation.
+ *
+ * Usage: microbench [-r REPETITIONS] [-w WARMUP] [-s SEED] [-j MAX_THREADS] [FILTER]
+ * Only the benchmarks whose name contains FILTER are run. With -j, the parallel search is also timed with
+ * 1, 2, 4, ... up to MAX_THREADS threads on the generated boards, and its speed-ups over 1 thread are printed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+#include "a_star.h"
+#include "implicit_graph.h"
+#include "landmarks.h"
+#include "parallel_search.h"
+#include "bucket_search.h"
+#include "portfolio.h"
+#include "instance_gen.h"
+#include "util.h"
+
+#define PQ_KEY_TYPE PathMetric
+#define PQ_VAL_TYPE Uint16Point
+#include "pqueue.h"
+
+
+
+#define DEFAULT_REPETITIONS 20
+#define DEFAULT_WARMUP      3
+#define DEFAULT_SEED        1006
+#define BOARD_SIZE          1000000 // size of the unreduced generated boards, like the largest inputs
+#define PQ_POPS             (1 << 18) // pops per sample of the priority queue benchmark
+#define PQ_VERIFY_POPS      (1 << 13) // pops to compare with the reference queue
+#define MAX_SAMPLES         1000
+#define MAX_THREADS         256
+
+
+
+// run one sample and return the measured time in nanoseconds
+typedef double (*SampleFunc)(void* ctx);
+
+typedef struct BenchConfig {
+    unsigned long repetitions;
+    unsigned long warmup;
+    uint64_t seed;
+    unsigned long max_threads; // of the thread sweep, 0 to skip it
+    const char* filter;        // NULL to run all benchmarks
+} BenchConfig;
+
+
+
+static int compare_doubles(const void* a, const void* b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+static bool selected(const BenchConfig* const config, const char* name)
+{
+    return !config->filter || strstr(name, config->filter);
+}
+
+
+// Run the warm-up and the measured samples of a benchmark and print the statistics per operation.
+// Returns the median.
+static double measure(const BenchConfig* const config, const char* name, SampleFunc sample, void* ctx,
+                    const unsigned long ops_per_sample)
+{
+    double samples[MAX_SAMPLES];
+    for(unsigned long i = 0; i < config->warmup; i++) {
+        sample(ctx);
+    }
+    for(unsigned long i = 0; i < config->repetitions; i++) {
+        samples[i] = sample(ctx) / (double)ops_per_sample;
+    }
+    const size_t n = config->repetitions;
+    qsort(samples, n, sizeof(double), compare_doubles);
+    double sum = 0;
+    for(size_t i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    const double mean = sum / (double)n;
+    double squares = 0;
+    for(size_t i = 0; i < n; i++) {
+        squares += (samples[i] - mean) * (samples[i] - mean);
+    }
+    const double stddev = n > 1 ? sqrt(squares / (double)(n - 1)) : 0.0;
+    const double median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    printf("%-40s %12.1f %12.1f %12.1f %10.1f\n", name, samples[0], median, mean, stddev);
+    return median;
+}
+
+
+
+/*
+ * Priority queue
+ *
+ * The keys follow the pattern of an A* search with the manhattan heuristic: every popped node has up to
+ * 3 new neighbors, and the f_score of a neighbor is the f_score of the node plus 0 or 2 in length (towards
+ * or away from the goal), sometimes with an additional intersection. The script of the branching and the
+ * key increments is generated in advance, so the random number generator is not measured.
+ * Every inserted pair has its own id, so the indexed heap runs the same script without any decrease-key.
+ */
+
+typedef struct PqScript {
+    uint8_t* steps; // for each pop: number of children in bits 0-1, then 2 bits per child (intersection, away)
+    size_t pops;
+} PqScript;
+
+
+static PqScript pq_script_new(GenRng* rng, const size_t pops)
+{
+    PqScript script = {.steps = malloc(pops * sizeof(uint8_t)), .pops = pops};
+    if(!script.steps) {
+        fprintf(stderr, "Allocation for priority queue script failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < pops; i++) {
+        const uint32_t r = gen_below(rng, 20);
+        uint8_t children = r < 5 ? 0 : r < 13 ? 1 : r < 18 ? 2 : 3; // 1.2 children per pop on average
+        uint8_t step = children;
+        for(unsigned c = 0; c < children; c++) {
+            const uint8_t intersection = gen_below(rng, 8) == 0;
+            const uint8_t away = gen_below(rng, 2) == 0;
+            step |= (uint8_t)(((intersection << 1) | away) << (2 + 2 * c));
+        }
+        script.steps[i] = step;
+    }
+    return script;
+}
+
+
+static inline PathMetric pq_script_child(const PathMetric parent, const uint8_t step, const unsigned c)
+{
+    const unsigned bits = (step >> (2 + 2 * c)) & 0x3;
+    return (PathMetric) {(uint16_t)(parent.intersections + (bits >> 1)), (uint16_t)(parent.length + 2 * (bits & 1))};
+}
+
+
+static inline uint64_t key_checksum(const uint64_t sum, const PathMetric key)
+{
+    return sum * 31 + ((uint64_t)key.intersections << 16 | key.length);
+}
+
+
+// id of a pair of the script for the indexed heap, the values are the ids split into two halves
+static size_t pq_script_id(const void* context, const KeyValPair pair)
+{
+    (void)context;
+    return (size_t)pair.val.x | (size_t)pair.val.y << 16;
+}
+
+
+// Play the script on a PQueue, an indexed one iff indexed. Returns the checksum of the popped keys.
+static uint64_t pq_run_script(const PqScript* const script, const size_t pops, const bool indexed)
+{
+    PQueue* q = indexed ? pq_new_indexed(cheaper_path, 3 * pops + 3, pq_script_id, NULL) : pq_new(cheaper_path);
+    pq_insert(q, (KeyValPair) {.key = {0, 0}, .val = {0, 0}});
+    uint64_t checksum = 0;
+    for(size_t i = 0; i < pops && !pq_is_empty(q); i++) {
+        const KeyValPair current = pq_pop(q);
+        checksum = key_checksum(checksum, current.key);
+        const uint8_t step = script->steps[i];
+        for(unsigned c = 0; c < (step & 0x3u); c++) {
+            const size_t id = 3 * (i + 1) + c;
+            pq_insert(q, (KeyValPair) {.key = pq_script_child(current.key, step, c),
+                                       .val = {(uint16_t)(id & 0xFFFF), (uint16_t)(id >> 16)}});
+        }
+    }
+    pq_free(q);
+    return checksum;
+}
+
+
+// The same with a sorted array as the queue, as a reference for the results.
+static uint64_t reference_run_script(const PqScript* const script, const size_t pops)
+{
+    size_t capacity = 3 * pops + 1;
+    PathMetric* sorted = malloc(capacity * sizeof(PathMetric)); // in descending order, the minimum is last
+    if(!sorted) {
+        fprintf(stderr, "Allocation for reference queue failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    sorted[n++] = (PathMetric) {0, 0};
+    uint64_t checksum = 0;
+    for(size_t i = 0; i < pops && n > 0; i++) {
+        const PathMetric current = sorted[--n];
+        checksum = key_checksum(checksum, current);
+        const uint8_t step = script->steps[i];
+        for(unsigned c = 0; c < (step & 0x3u); c++) {
+            const PathMetric key = pq_script_child(current, step, c);
+            size_t pos = n;
+            while(pos > 0 && cheaper_path(sorted[pos - 1], key)) {
+                sorted[pos] = sorted[pos - 1];
+                pos--;
+            }
+            sorted[pos] = key;
+            n++;
+        }
+    }
+    free(sorted);
+    return checksum;
+}
+
+
+static double sample_pq(void* ctx)
+{
+    const PqScript* script = ctx;
+    const double start = now_ns();
+    volatile uint64_t checksum = pq_run_script(script, script->pops, false);
+    (void)checksum;
+    return now_ns() - start;
+}
+
+
+static double sample_pq_indexed(void* ctx)
+{
+    const PqScript* script = ctx;
+    const double start = now_ns();
+    volatile uint64_t checksum = pq_run_script(script, script->pops, true);
+    (void)checksum;
+    return now_ns() - start;
+}
+
+
+static void bench_pqueue(const BenchConfig* const config)
+{
+    const bool binary = selected(config, "pq/insert+pop (per pop)");
+    const bool indexed = selected(config, "pq/indexed insert+pop (per pop)");
+    if(!binary && !indexed) {
+        return;
+    }
+    GenRng rng = {config->seed};
+    PqScript script = pq_script_new(&rng, PQ_POPS);
+    const uint64_t expected = reference_run_script(&script, PQ_VERIFY_POPS);
+    if(pq_run_script(&script, PQ_VERIFY_POPS, false) != expected ||
+       pq_run_script(&script, PQ_VERIFY_POPS, true) != expected) {
+        fprintf(stderr, "pq: popped keys differ from the reference queue.\n");
+        exit(EXIT_FAILURE);
+    }
+    if(binary) {
+        measure(config, "pq/insert+pop (per pop)", sample_pq, &script, PQ_POPS);
+    }
+    if(indexed) {
+        measure(config, "pq/indexed insert+pop (per pop)", sample_pq_indexed, &script, PQ_POPS);
+    }
+    free(script.steps);
+}
+
+
+
+/*
+ * reduce_worker
+ */
+
+typedef struct ReduceCtx {
+    const int32_t* values; // the coordinates of one direction, 2 * m + 3 of them like in reduce
+    size_t length;
+    size_t batch; // calls per sample
+    int32_t* work;
+    int32_t** ptrs;
+} ReduceCtx;
+
+
+static double sample_reduce(void* ctx)
+{
+    ReduceCtx* c = ctx;
+    // copy the original values for every call of the batch first, since reduce_worker works in place
+    for(size_t b = 0; b < c->batch; b++) {
+        memcpy(c->work + b * c->length, c->values, c->length * sizeof(int32_t));
+        for(size_t i = 0; i < c->length; i++) {
+            c->ptrs[b * c->length + i] = c->work + b * c->length + i;
+        }
+    }
+    const double start = now_ns();
+    for(size_t b = 0; b < c->batch; b++) {
+        reduce_worker(c->ptrs + b * c->length, c->length);
+    }
+    return now_ns() - start;
+}
+
+
+static void bench_reduce(const BenchConfig* const config)
+{
+    const int ms[] = {10, 100, 1000, 10000};
+    for(size_t k = 0; k < sizeof(ms) / sizeof(ms[0]); k++) {
+        char name[64];
+        snprintf(name, sizeof(name), "reduce_worker/m=%d", ms[k]);
+        if(!selected(config, name)) {
+            continue;
+        }
+        GenRng rng = {config->seed + (uint64_t)k};
+        EndpointRepr er;
+        gen_instance(&er, &rng, ms[k], BOARD_SIZE);
+        ReduceCtx c = {.length = 2 * (size_t)ms[k] + 3};
+        c.batch = 100000 / c.length + 1;
+        int32_t* values = malloc(c.length * sizeof(int32_t));
+        c.work = malloc(c.batch * c.length * sizeof(int32_t));
+        c.ptrs = malloc(c.batch * c.length * sizeof(int32_t*));
+        if(!values || !c.work || !c.ptrs) {
+            fprintf(stderr, "Allocation for reduce benchmark failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        for(int i = 0; i < er.m; i++) { // the x coordinates, like reduce collects them
+            values[2 * i] = er.wires[i].x1;
+            values[2 * i + 1] = er.wires[i].x2;
+        }
+        values[c.length - 3] = er.width;
+        values[c.length - 2] = er.p1x;
+        values[c.length - 1] = er.p2x;
+        c.values = values;
+        measure(config, name, sample_reduce, &c, c.batch);
+        free(values);
+        free(c.work);
+        free(c.ptrs);
+        free(er.wires);
+    }
+}
+
+
+
+/*
+ * build_graph
+ */
+
+typedef struct BuildCtx {
+    const EndpointRepr* er; // reduced
+    size_t batch;
+    Graph** graphs;
+} BuildCtx;
+
+
+static double sample_build(void* ctx)
+{
+    BuildCtx* c = ctx;
+    const double start = now_ns();
+    for(size_t b = 0; b < c->batch; b++) {
+        c->graphs[b] = build_graph(c->er);
+    }
+    const double elapsed = now_ns() - start;
+    for(size_t b = 0; b < c->batch; b++) {
+        graph_free(c->graphs[b]);
+    }
+    return elapsed;
+}
+
+
+static void bench_build_graph(const BenchConfig* const config)
+{
+    const int ms[] = {10, 100, 1000};
+    for(size_t k = 0; k < sizeof(ms) / sizeof(ms[0]); k++) {
+        GenRng rng = {config->seed + (uint64_t)k};
+        EndpointRepr er;
+        gen_instance(&er, &rng, ms[k], BOARD_SIZE);
+        reduce(&er);
+        char name[64];
+        snprintf(name, sizeof(name), "build_graph/m=%d (%" PRId32 "x%" PRId32 ")", ms[k], er.width, er.height);
+        if(selected(config, name)) {
+            const size_t nodes = (size_t)er.width * (size_t)er.height;
+            BuildCtx c = {.er = &er, .batch = 1000000 / nodes + 1};
+            c.graphs = malloc(c.batch * sizeof(Graph*));
+            if(!c.graphs) {
+                fprintf(stderr, "Allocation for build_graph benchmark failed.\n");
+                exit(EXIT_FAILURE);
+            }
+            measure(config, name, sample_build, &c, c.batch);
+            free(c.graphs);
+        }
+        free(er.wires);
+    }
+}
+
+
+
+/*
+ * Search variants
+ */
+
+typedef enum SearchVariant {
+    SEARCH_DEFAULT,
+    SEARCH_COMPACT,
+    SEARCH_IMPLICIT,
+    SEARCH_LANDMARKS,
+    SEARCH_ANYTIME,
+    SEARCH_PARALLEL,
+    SEARCH_INDEXED,
+    SEARCH_BUCKET,
+    SEARCH_ZERO_CHECK,
+    SEARCH_VARIANT_COUNT
+} SearchVariant;
+
+static const char* const search_variant_names[SEARCH_VARIANT_COUNT] = {
+    "a_star_cost", "a_star_cost_compact", "a_star_implicit_cost", "a_star_cost+landmarks",
+    "a_star_anytime", "parallel_search_cost/1", "a_star_cost+indexed_pq", "bucket_search_cost",
+    "zero_check+a_star_cost"};
+
+typedef struct SearchCtx {
+    const Graph* graph;
+    const ImplicitGraph* implicit_graph;
+    SearchVariant variant;
+    int16_t result;
+} SearchCtx;
+
+
+static int16_t run_search(const SearchCtx* const c)
+{
+    switch(c->variant) {
+        case SEARCH_DEFAULT:
+            return a_star_cost(c->graph, manhattan_distance);
+        case SEARCH_COMPACT:
+            return a_star_cost_compact(c->graph, manhattan_distance);
+        case SEARCH_IMPLICIT:
+            return a_star_implicit_cost(c->implicit_graph, manhattan_distance);
+        case SEARCH_LANDMARKS:
+            return a_star_cost(c->graph, landmark_heuristic);
+        case SEARCH_ANYTIME:
+            return a_star_anytime(c->graph, manhattan_distance, (AnytimeBudget) {0, 0}, NULL).cost;
+        case SEARCH_PARALLEL:
+            return parallel_search_cost(c->graph, 1);
+        case SEARCH_INDEXED: {
+            a_star_use_indexed_queue(true);
+            const int16_t result = a_star_cost(c->graph, manhattan_distance);
+            a_star_use_indexed_queue(false);
+            return result;
+        }
+        case SEARCH_BUCKET:
+            return bucket_search_cost(c->graph);
+        case SEARCH_ZERO_CHECK:
+            return portfolio_solve(c->graph, manhattan_distance, ENGINE_ZERO_CHECK);
+        default:
+            return -2;
+    }
+}
+
+
+static double sample_search(void* ctx)
+{
+    SearchCtx* c = ctx;
+    const double start = now_ns();
+    c->result = run_search(c);
+    return now_ns() - start;
+}
+
+
+static void bench_search(const BenchConfig* const config)
+{
+    const int ms[] = {10, 30, 100};
+    for(size_t k = 0; k < sizeof(ms) / sizeof(ms[0]); k++) {
+        GenRng rng = {config->seed + (uint64_t)k};
+        EndpointRepr er;
+        gen_instance(&er, &rng, ms[k], BOARD_SIZE);
+        LandmarkSet* landmarks = landmarks_compute(&er, 4);
+        int32_t* x_coords;
+        int32_t* y_coords;
+        reduce_with_points(&er, NULL, NULL, 0, 1, &x_coords, &y_coords);
+        Graph* graph = build_graph(&er);
+        ImplicitGraph* implicit_graph = implicit_graph_new(&er);
+        landmarks_activate(landmarks, graph, x_coords, y_coords);
+        free(x_coords);
+        free(y_coords);
+
+        // all variants must agree before any of them is measured
+        SearchCtx c = {.graph = graph, .implicit_graph = implicit_graph};
+        int16_t expected = 0;
+        size_t peak_queue_sizes[SEARCH_VARIANT_COUNT] = {0};
+        for(int v = 0; v < SEARCH_VARIANT_COUNT; v++) {
+            c.variant = (SearchVariant)v;
+            const int16_t result = run_search(&c);
+            peak_queue_sizes[v] = a_star_peak_queue_size(); // only meaningful for the variants using a_star_cost
+            if(v == 0) {
+                expected = result;
+            }
+            else if(result != expected) {
+                fprintf(stderr, "%s returned %d instead of %d on the board with m = %d.\n", search_variant_names[v],
+                        result, expected, ms[k]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        for(int v = 0; v < SEARCH_VARIANT_COUNT; v++) {
+            char name[96];
+            snprintf(name, sizeof(name), "%s/m=%d (cost %d)", search_variant_names[v], ms[k], expected);
+            if(selected(config, name)) {
+                c.variant = (SearchVariant)v;
+                measure(config, name, sample_search, &c, 1);
+            }
+        }
+        if(selected(config, "a_star_cost")) {
+            printf("  peak queue size m=%d: %zu (binary heap), %zu (indexed heap)\n", ms[k],
+                   peak_queue_sizes[SEARCH_DEFAULT], peak_queue_sizes[SEARCH_INDEXED]);
+        }
+        landmarks_free(landmarks);
+        implicit_graph_free(implicit_graph);
+        graph_free(graph);
+        free(er.wires);
+    }
+}
+
+
+
+/*
+ * Thread sweep of the parallel search
+ *
+ * The same boards as for the search variants, searched with 1, 2, 4, ... threads. The speed-up of n
+ * threads is the median time with 1 thread divided by the median time with n threads.
+ */
+
+typedef struct ParallelCtx {
+    const Graph* graph;
+    unsigned threads;
+    int16_t result;
+} ParallelCtx;
+
+
+static double sample_parallel(void* ctx)
+{
+    ParallelCtx* c = ctx;
+    const double start = now_ns();
+    c->result = parallel_search_cost(c->graph, c->threads);
+    return now_ns() - start;
+}
+
+
+static void bench_thread_sweep(const BenchConfig* const config)
+{
+    printf("thread sweep on %ld online processors\n", sysconf(_SC_NPROCESSORS_ONLN));
+    const int ms[] = {10, 30, 100};
+    for(size_t k = 0; k < sizeof(ms) / sizeof(ms[0]); k++) {
+        GenRng rng = {config->seed + (uint64_t)k};
+        EndpointRepr er;
+        gen_instance(&er, &rng, ms[k], BOARD_SIZE);
+        reduce(&er);
+        Graph* graph = build_graph(&er);
+        const int16_t expected = a_star_cost(graph, manhattan_distance);
+
+        ParallelCtx c = {.graph = graph};
+        double single = 0; // median time with 1 thread, 0 if it was not measured
+        for(unsigned long threads = 1; threads <= config->max_threads; threads *= 2) {
+            char name[96];
+            snprintf(name, sizeof(name), "parallel_search_cost/j=%lu/m=%d (cost %d)", threads, ms[k], expected);
+            if(!selected(config, name)) {
+                continue;
+            }
+            c.threads = (unsigned)threads;
+            const int16_t result = parallel_search_cost(graph, c.threads);
+            if(result != expected) {
+                fprintf(stderr, "parallel_search_cost with %lu threads returned %d instead of %d on the board with "
+                                "m = %d.\n", threads, result, expected, ms[k]);
+                exit(EXIT_FAILURE);
+            }
+            const double median = measure(config, name, sample_parallel, &c, 1);
+            if(threads == 1) {
+                single = median;
+            }
+            else if(single > 0) {
+                printf("  speed-up with %lu threads: %.2f\n", threads, single / median);
+            }
+        }
+        graph_free(graph);
+        free(er.wires);
+    }
+}
+
+
+
+int main(int argc, char** argv)
+{
+    BenchConfig config = {.repetitions = DEFAULT_REPETITIONS, .warmup = DEFAULT_WARMUP, .seed = DEFAULT_SEED};
+    unsigned long seed = DEFAULT_SEED;
+    int c;
+    while((c = getopt(argc, argv, "r:w:s:j:")) != -1) {
+        switch(c) {
+            case 'r':
+                if(!parse_ulong_arg(optarg, &config.repetitions) || config.repetitions == 0 ||
+                   config.repetitions > MAX_SAMPLES) {
+                    fprintf(stderr, "Invalid number of repetitions `%s' (1 to %d).\n", optarg, MAX_SAMPLES);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'w':
+                if(!parse_ulong_arg(optarg, &config.warmup)) {
+                    fprintf(stderr, "Invalid number of warm-up samples `%s'.\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                if(!parse_ulong_arg(optarg, &seed)) {
+                    fprintf(stderr, "Invalid seed `%s'.\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                config.seed = seed;
+                break;
+            case 'j':
+                if(!parse_ulong_arg(optarg, &config.max_threads) || config.max_threads == 0 ||
+                   config.max_threads > MAX_THREADS) {
+                    fprintf(stderr, "Invalid number of threads `%s' (1 to %d).\n", optarg, MAX_THREADS);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-r REPETITIONS] [-w WARMUP] [-s SEED] [-j MAX_THREADS] [FILTER]\n",
+                        argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    config.filter = optind < argc ? argv[optind] : NULL;
+
+    printf("%-40s %12s %12s %12s %10s\n", "benchmark (ns per operation)", "min", "median", "mean", "stddev");
+    bench_pqueue(&config);
+    bench_reduce(&config);
+    bench_build_graph(&config);
+    bench_search(&config);
+    if(config.max_threads) {
+        bench_thread_sweep(&config);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+#include "multi_net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+// key to sort the nets by for the chosen order, ties are broken by the index to keep the input order
+typedef struct NetRank {
+    int64_t key;
+    int index;
+} NetRank;
+
+
+
+bool net_order_parse(const char* name, NetOrder* order)
+{
+    if(strcmp(name, "input") == 0) {
+        *order = NET_ORDER_INPUT;
+    }
+    else if(strcmp(name, "short") == 0) {
+        *order = NET_ORDER_SHORT;
+    }
+    else if(strcmp(name, "long") == 0) {
+        *order = NET_ORDER_LONG;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+
+
+// Comparison function for qsort
+static int compare_net_ranks(const void* a, const void* b)
+{
+    const NetRank* ra = a;
+    const NetRank* rb = b;
+    if(ra->key != rb->key) {
+        return (ra->key > rb->key) - (ra->key < rb->key);
+    }
+    return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+// Write the indices of the nets in the order in which they are routed to routing_order.
+static void net_routing_order(const Net* const nets, const int net_count, const NetOrder order, int* routing_order)
+{
+    NetRank* ranks = malloc((size_t)net_count * sizeof(NetRank));
+    if(!ranks) {
+        fprintf(stderr, "Allocation for net order failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < net_count; i++) {
+        const int64_t distance = llabs((int64_t)nets[i].p1x - nets[i].p2x) + llabs((int64_t)nets[i].p1y - nets[i].p2y);
+        ranks[i].key = order == NET_ORDER_SHORT ? distance : order == NET_ORDER_LONG ? -distance : 0;
+        ranks[i].index = i;
+    }
+    qsort(ranks, (size_t)net_count, sizeof(NetRank), compare_net_ranks);
+    for(int i = 0; i < net_count; i++) {
+        routing_order[i] = ranks[i].index;
+    }
+    free(ranks);
+}
+
+
+
+// Returns true iff the reduction removed lines between line c of the reduced graph (of size lines, mapped
+// to the input by coords) and the next line, or the border of the input (of size input_size) after it.
+static inline bool lines_removed_after(const int32_t* const coords, const uint16_t size, const int32_t input_size,
+                                       const uint16_t c)
+{
+    const int32_t next = c + 1 < size ? coords[c + 1] : input_size;
+    return next - coords[c] > 1;
+}
+
+// Append a net to extra that keeps the line x (if y < 0) or y (if x < 0) of the input, with the other
+// coordinate taken from anchor, which is kept anyway. Lines that are in extra already are skipped.
+static void keep_line(Net** extra, size_t* extra_count, const Net* const anchor, const int32_t x, const int32_t y)
+{
+    const Net line = {x >= 0 ? x : anchor->p1x, y >= 0 ? y : anchor->p1y, x >= 0 ? x : anchor->p1x,
+                      y >= 0 ? y : anchor->p1y};
+    for(size_t i = 0; i < *extra_count; i++) {
+        if(memcmp(&(*extra)[i], &line, sizeof(Net)) == 0) {
+            return;
+        }
+    }
+    *extra = realloc(*extra, (*extra_count + 1) * sizeof(Net));
+    if(!*extra) {
+        fprintf(stderr, "Allocation for kept lines failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    (*extra)[(*extra_count)++] = line;
+}
+
+// Find the gaps that were narrowed by the reduction and in which the route has a node on the last free
+// line, other than crossing that line straight. The removed lines are copies of the last free line in front
+// of them as long as no route runs along it or turns on it. Once one does, the following nets would see a
+// wider gap on the full grid, so the reduced graph is not exact for them anymore. The first removed line of
+// each such gap is appended to extra [see keep_line]. Returns true iff any gap was found.
+static bool find_filled_gaps(const Uint16Point* const path, const size_t length, const MultiNetResult* const result,
+                             const int32_t input_width, const int32_t input_height, const Net* const anchor,
+                             Net** extra, size_t* extra_count)
+{
+    const Graph* const g = result->graph;
+    const size_t count_before = *extra_count;
+    for(size_t i = 0; i < length; i++) {
+        const Uint16Point p = path[i];
+        const bool inner = i > 0 && i + 1 < length;
+        const bool straight_x = inner && path[i - 1].y == p.y && path[i + 1].y == p.y;
+        const bool straight_y = inner && path[i - 1].x == p.x && path[i + 1].x == p.x;
+        if(!straight_x && lines_removed_after(result->x_coords, g->width, input_width, p.x)) {
+            keep_line(extra, extra_count, anchor, result->x_coords[p.x] + 1, -1);
+        }
+        if(!straight_y && lines_removed_after(result->y_coords, g->height, input_height, p.y)) {
+            keep_line(extra, extra_count, anchor, -1, result->y_coords[p.y] + 1);
+        }
+    }
+    return *extra_count > count_before;
+}
+
+
+// Reduce er, after restoring it from input and input_wires, together with the endpoints of the nets and of
+// the extra_count nets in extra, and build its graph. The endpoints of the nets in the reduced graph are
+// written to reduced_nets, the graph and the maps of the coordinates to result.
+static void reduce_nets(EndpointRepr* const er, const EndpointRepr* const input, const Wire* const input_wires,
+                        const Net* const nets, const int net_count, const Net* const extra,
+                        const size_t extra_count, Net* const reduced_nets, MultiNetResult* const result)
+{
+    *er = *input;
+    memcpy(er->wires, input_wires, (size_t)er->m * sizeof(Wire));
+    const size_t count = (size_t)net_count + extra_count;
+    Net* all = malloc(count * sizeof(Net)); // the extra nets are reduced with the others, but not routed
+    int32_t** xs = malloc(2 * count * sizeof(int32_t*));
+    int32_t** ys = malloc(2 * count * sizeof(int32_t*));
+    if(!all || !xs || !ys) {
+        fprintf(stderr, "Allocating helper arrays for reduction failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(all, nets, (size_t)net_count * sizeof(Net));
+    if(extra_count > 0) {
+        memcpy(all + net_count, extra, extra_count * sizeof(Net));
+    }
+    for(size_t i = 0; i < count; i++) {
+        xs[2 * i] = &(all[i].p1x);
+        ys[2 * i] = &(all[i].p1y);
+        xs[2 * i + 1] = &(all[i].p2x);
+        ys[2 * i + 1] = &(all[i].p2y);
+    }
+    reduce_with_points(er, xs, ys, 2 * count, MULTI_NET_FREE_LINES, &result->x_coords, &result->y_coords);
+    memcpy(reduced_nets, all, (size_t)net_count * sizeof(Net));
+    free(xs);
+    free(ys);
+    free(all);
+    result->graph = build_graph(er);
+}
+
+
+// index of the line of the reduced graph that the coordinate value of the input is mapped to
+static uint16_t reduced_line(const int32_t* const coords, const uint16_t size, const int32_t value)
+{
+    uint16_t low = 0;
+    uint16_t high = size; // coords is strictly increasing
+    while(high - low > 1) {
+        const uint16_t mid = (uint16_t)(low + (high - low) / 2);
+        if(coords[mid] <= value) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+    assert(coords[low] == value);
+    return low;
+}
+
+// Translate the path of route from the reduced graph mapped by old_x_coords and old_y_coords to the one of
+// result, which keeps all lines of the old one. A step over lines that were added in between becomes a
+// straight run across them.
+static void translate_route(Route* const route, const int32_t* const old_x_coords, const int32_t* const old_y_coords,
+                            const MultiNetResult* const result)
+{
+    const Graph* const g = result->graph;
+    Uint16Point* nodes = malloc(route->length * sizeof(Uint16Point));
+    if(!nodes) {
+        fprintf(stderr, "Allocation for route failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t length = 1;
+    for(size_t i = 0; i < route->length; i++) {
+        nodes[i].x = reduced_line(result->x_coords, g->width, old_x_coords[route->path[i].x]);
+        nodes[i].y = reduced_line(result->y_coords, g->height, old_y_coords[route->path[i].y]);
+        if(i > 0) {
+            length += (size_t)abs(nodes[i].x - nodes[i - 1].x) + (size_t)abs(nodes[i].y - nodes[i - 1].y);
+        }
+    }
+    Uint16Point* path = realloc(route->path, length * sizeof(Uint16Point));
+    if(!path) {
+        fprintf(stderr, "Allocation for route failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t k = 0;
+    path[k++] = nodes[0];
+    for(size_t i = 1; i < route->length; i++) {
+        Uint16Point p = nodes[i - 1];
+        while(p.x != nodes[i].x || p.y != nodes[i].y) {
+            p.x = (uint16_t)(p.x < nodes[i].x ? p.x + 1 : p.x > nodes[i].x ? p.x - 1 : p.x);
+            p.y = (uint16_t)(p.y < nodes[i].y ? p.y + 1 : p.y > nodes[i].y ? p.y - 1 : p.y);
+            path[k++] = p;
+        }
+    }
+    assert(k == length);
+    free(nodes);
+    route->path = path;
+    route->length = length;
+}
+
+
+
+MultiNetResult multi_net_route(EndpointRepr* const er, const Net* const nets, const int net_count,
+                               const NetOrder order, HeuristicFunc h)
+{
+    assert(er && er->m > 0 && nets && net_count >= 1);
+    // reduce changes er in place, so every further reduction starts from a copy of the input
+    const EndpointRepr input = *er;
+    Wire* input_wires = malloc((size_t)er->m * sizeof(Wire));
+    Net* reduced_nets = malloc((size_t)net_count * sizeof(Net));
+    int* routing_order = malloc((size_t)net_count * sizeof(int));
+    MultiNetResult result = {.net_count = net_count, .total_cost = 0, .unrouted = 0};
+    result.routes = calloc((size_t)net_count, sizeof(Route));
+    if(!input_wires || !reduced_nets || !routing_order || !result.routes) {
+        fprintf(stderr, "Allocation for routes failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(input_wires, er->wires, (size_t)er->m * sizeof(Wire));
+    net_routing_order(nets, net_count, order, routing_order);
+    Net* extra = NULL; // lines kept to widen the gaps that filled up
+    size_t extra_count = 0;
+    reduce_nets(er, &input, input_wires, nets, net_count, extra, extra_count, reduced_nets, &result);
+    Graph* g = result.graph;
+    Uint16Point* path = malloc((size_t)g->width * g->height * sizeof(Uint16Point));
+    if(!path) {
+        fprintf(stderr, "Allocation for routes failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(int i = 0; i < net_count; i++) {
+        const Net* const net = &reduced_nets[routing_order[i]];
+        Route* const route = &result.routes[routing_order[i]];
+        g->p1 = (Uint16Point) {(uint16_t)net->p1x, (uint16_t)net->p1y};
+        g->p2 = (Uint16Point) {(uint16_t)net->p2x, (uint16_t)net->p2y};
+        route->cost = a_star_path(g, h, path, &route->length);
+        if(route->cost < 0) {
+            result.unrouted++;
+            continue;
+        }
+        route->path = malloc(route->length * sizeof(Uint16Point));
+        if(!route->path) {
+            fprintf(stderr, "Allocation for route failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(route->path, path, route->length * sizeof(Uint16Point));
+        graph_add_route(g, path, route->length, 1); // the following nets have to cross it
+        result.total_cost += route->cost;
+
+        // Keep the first removed line of every gap the route filled up, which adds MULTI_NET_FREE_LINES free
+        // lines behind it, and move the routes so far to the new reduced graph.
+        if(i + 1 < net_count && find_filled_gaps(route->path, route->length, &result, input.width, input.height,
+                                                 &nets[0], &extra, &extra_count)) {
+            int32_t* old_x_coords = result.x_coords;
+            int32_t* old_y_coords = result.y_coords;
+            graph_free(g);
+            reduce_nets(er, &input, input_wires, nets, net_count, extra, extra_count, reduced_nets, &result);
+            g = result.graph;
+            for(int j = 0; j <= i; j++) {
+                Route* const routed = &result.routes[routing_order[j]];
+                if(routed->path) {
+                    translate_route(routed, old_x_coords, old_y_coords, &result);
+                    graph_add_route(g, routed->path, routed->length, 1);
+                }
+            }
+            free(old_x_coords);
+            free(old_y_coords);
+            path = realloc(path, (size_t)g->width * g->height * sizeof(Uint16Point));
+            if(!path) {
+                fprintf(stderr, "Allocation for routes failed.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    free(path);
+    free(extra);
+    free(routing_order);
+    free(reduced_nets);
+    free(input_wires);
+    return result;
+}
+
+
+
+void multi_net_result_free(MultiNetResult* result)
+{
+    for(int i = 0; i < result->net_count; i++) {
+        free(result->routes[i].path);
+    }
+    free(result->routes);
+    free(result->x_coords);
+    free(result->y_coords);
+    graph_free(result->graph);
+    result->routes = NULL;
+    result->graph = NULL;
+}
@@ -0,0 +1,81 @@
+#ifndef _MULTI_NET_H
+#define _MULTI_NET_H
+
+
+/*
+ * Sequential multi-net router
+ *
+ * Routes a list of nets (pairs of endpoints) on the same board one after another, where every routed net
+ * becomes a wire that the following nets have to cross. Instead of appending each route to the wires and
+ * starting over with reduce and build_graph, the endpoints of all nets are included in a single reduction,
+ * the graph is built once and every route is added to it in place [see graph_add_route].
+ * Routes can run through the gaps between the coordinates of the input, of which the normal reduction only
+ * keeps a single free line. A route through such a line would cut the gap for all following nets although
+ * the full grid leaves room on both sides, so up to MULTI_NET_FREE_LINES free lines are kept instead. If a
+ * route still takes the last free line of a narrowed gap, the gap is widened and the routes so far are moved
+ * to the new reduced graph, so the cost of every net is the same as on the full grid with the same routes
+ * before it.
+ * The routes are translated back to the coordinates of the input with a map per axis.
+ */
+
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+#include "a_star.h"
+
+
+#define MULTI_NET_FREE_LINES 3
+
+
+
+// the endpoints of a connection to route
+typedef struct Net {
+    int32_t p1x;
+    int32_t p1y;
+    int32_t p2x;
+    int32_t p2y;
+} Net;
+
+// order in which the nets are routed
+typedef enum NetOrder {
+    NET_ORDER_INPUT, // as given in the input
+    NET_ORDER_SHORT, // shortest manhattan distance between the endpoints first
+    NET_ORDER_LONG,  // longest manhattan distance between the endpoints first
+} NetOrder;
+
+typedef struct Route {
+    int16_t cost;      // sum of the node costs along the route at the time it was routed, -1 if there was no path
+    size_t length;     // number of nodes, 0 if there was no path
+    Uint16Point* path; // the nodes in the reduced graph, from p1 to p2 of the net
+} Route;
+
+typedef struct MultiNetResult {
+    Graph* graph;      // the reduced graph with all routes added
+    int32_t* x_coords; // x_coords[x] is the coordinate of column x of graph in the input, likewise y_coords
+    int32_t* y_coords;
+    int net_count;
+    Route* routes;     // in the order of the input, not in the order of routing
+    long total_cost;   // sum of the costs of all nets that could be routed
+    int unrouted;      // number of nets without a path, which are not included in total_cost
+} MultiNetResult;
+
+
+
+// Parse the name of a NetOrder ("input", "short" or "long"). Returns false if the name is unknown.
+bool net_order_parse(const char* name, NetOrder* order);
+
+// Route the nets (in the coordinates of the input) on the board of er in the given order, each one with
+// A* and the heuristic h. er must not have been reduced yet, it is reduced in place. net_count must be >= 1.
+// Caller is responsible for freeing the result with multi_net_result_free.
+MultiNetResult multi_net_route(EndpointRepr* const er, const Net* const nets, const int net_count,
+                               const NetOrder order, HeuristicFunc h);
+void multi_net_result_free(MultiNetResult* result);
+
+
+
+#endif
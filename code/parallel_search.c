@@ -0,0 +1,293 @@
+#define _POSIX_C_SOURCE 200809L // for pthread barriers
+
+#include "parallel_search.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+
+
+
+#define DIST_INFINITY UINT16_MAX
+
+
+
+// growable array of node ids
+typedef struct IdVec {
+    uint32_t* ids;
+    size_t n;
+    size_t allocated_n;
+} IdVec;
+
+// per thread output of one phase
+typedef struct ThreadLocal {
+    IdVec same_bucket; // nodes reached with a move of cost 0, i.e. part of the next phase
+    IdVec* ring;       // nodes reached with a move of cost > 0, for each bucket of the ring
+} ThreadLocal;
+
+typedef struct SearchState {
+    const Graph* g;
+    unsigned num_threads;
+    atomic_uint_least16_t* dist; // tentative distance of each node, indexed by x * height + y
+    uint16_t ring_size;          // max node cost + 1, so bucket k is stored in ring[k % ring_size]
+    IdVec* ring;
+    size_t ring_pending; // total number of ids in the ring
+    uint16_t k;          // distance of the bucket currently being processed
+    IdVec frontier;      // ids to be processed in the current phase
+    ThreadLocal* locals;
+    pthread_barrier_t barrier;
+    bool done;
+    int16_t result;
+} SearchState;
+
+typedef struct WorkerArg {
+    SearchState* state;
+    unsigned thread_id;
+} WorkerArg;
+
+
+
+static void idvec_push(IdVec* v, const uint32_t id)
+{
+    if(v->n == v->allocated_n) {
+        size_t new_n = v->allocated_n ? 2 * v->allocated_n : 64;
+        uint32_t* new_ptr = realloc(v->ids, new_n * sizeof(uint32_t));
+        if(!new_ptr) {
+            fprintf(stderr, "Reallocating node id array for parallel search failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        v->ids = new_ptr;
+        v->allocated_n = new_n;
+    }
+    v->ids[v->n++] = id;
+}
+
+// append all ids of src to dst and empty src
+static void idvec_move_append(IdVec* dst, IdVec* src)
+{
+    for(size_t i = 0; i < src->n; i++) {
+        idvec_push(dst, src->ids[i]);
+    }
+    src->n = 0;
+}
+
+static inline void idvec_swap(IdVec* a, IdVec* b)
+{
+    IdVec tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+
+
+// Lower dist[id] to new_dist if that is an improvement. Returns true iff this call lowered it.
+static inline bool relax(atomic_uint_least16_t* dist, const uint32_t id, const uint16_t new_dist)
+{
+    uint_least16_t old = atomic_load_explicit(&dist[id], memory_order_relaxed);
+    while(new_dist < old) {
+        if(atomic_compare_exchange_weak_explicit(&dist[id], &old, new_dist, memory_order_relaxed,
+                                                 memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+// expand this thread's share of the current frontier
+static void process_slice(SearchState* s, const unsigned thread_id)
+{
+    const Graph* g = s->g;
+    const uint16_t k = s->k;
+    const size_t begin = s->frontier.n * thread_id / s->num_threads;
+    const size_t end = s->frontier.n * (thread_id + 1) / s->num_threads;
+    ThreadLocal* local = &s->locals[thread_id];
+    const uint8_t* node_cost = g->node_cost[0];
+    const uint8_t* neighbors = g->neighbors[0];
+    for(size_t i = begin; i < end; i++) {
+        const uint32_t id = s->frontier.ids[i];
+        if(atomic_load_explicit(&s->dist[id], memory_order_relaxed) != k) {
+            continue; // stale, the node was reached more cheaply in the meantime
+        }
+        uint32_t neighbor_ids[4];
+        int neigh_count = 0;
+        const uint8_t bitmap = neighbors[id];
+        if(bitmap & NEIGH_X_NEG) {
+            neighbor_ids[neigh_count++] = id - g->height;
+        }
+        if(bitmap & NEIGH_X_POS) {
+            neighbor_ids[neigh_count++] = id + g->height;
+        }
+        if(bitmap & NEIGH_Y_NEG) {
+            neighbor_ids[neigh_count++] = id - 1;
+        }
+        if(bitmap & NEIGH_Y_POS) {
+            neighbor_ids[neigh_count++] = id + 1;
+        }
+        for(int j = 0; j < neigh_count; j++) {
+            const uint32_t neighbor = neighbor_ids[j];
+            const uint8_t cost = node_cost[neighbor];
+            if(relax(s->dist, neighbor, (uint16_t)(k + cost))) {
+                if(cost == 0) {
+                    idvec_push(&local->same_bucket, neighbor);
+                }
+                else {
+                    idvec_push(&local->ring[(k + cost) % s->ring_size], neighbor);
+                }
+            }
+        }
+    }
+}
+
+
+
+// Serial step between two phases: collect the output of all threads and set up the next frontier.
+// Sets s->done if the search is finished.
+static void advance(SearchState* s)
+{
+    const uint32_t goal = (uint32_t)s->g->p2.x * s->g->height + s->g->p2.y;
+    s->frontier.n = 0;
+    for(unsigned t = 0; t < s->num_threads; t++) {
+        idvec_move_append(&s->frontier, &s->locals[t].same_bucket);
+        for(uint16_t r = 0; r < s->ring_size; r++) {
+            s->ring_pending += s->locals[t].ring[r].n;
+            idvec_move_append(&s->ring[r], &s->locals[t].ring[r]);
+        }
+    }
+    if(s->frontier.n > 0) { // the current bucket is not finished yet
+        return;
+    }
+    // bucket k is finished, every node with distance k has its final distance now
+    while(true) {
+        if(atomic_load_explicit(&s->dist[goal], memory_order_relaxed) <= s->k) {
+            s->result = (int16_t)s->k;
+            s->done = true;
+            return;
+        }
+        if(s->ring_pending == 0) { // no more nodes to visit, there is no path
+            s->result = -1;
+            s->done = true;
+            return;
+        }
+        s->k++;
+        IdVec* bucket = &s->ring[s->k % s->ring_size];
+        if(bucket->n > 0) {
+            s->ring_pending -= bucket->n;
+            idvec_swap(&s->frontier, bucket);
+            return;
+        }
+    }
+}
+
+
+
+static void* worker(void* arg)
+{
+    SearchState* s = ((WorkerArg*)arg)->state;
+    const unsigned thread_id = ((WorkerArg*)arg)->thread_id;
+    while(true) {
+        pthread_barrier_wait(&s->barrier); // wait until the frontier is set up
+        if(s->done) {
+            return NULL;
+        }
+        process_slice(s, thread_id);
+        pthread_barrier_wait(&s->barrier); // wait until all threads have processed their slice
+        if(thread_id == 0) {
+            advance(s);
+        }
+    }
+}
+
+
+
+int16_t parallel_search_cost(const Graph* const g, const unsigned num_threads)
+{
+    assert(num_threads >= 1);
+    const size_t node_count = (size_t)g->width * g->height;
+    SearchState s = {.g = g, .num_threads = num_threads, .k = 0, .done = false, .result = -1};
+
+    uint8_t max_cost = 0;
+    for(size_t i = 0; i < node_count; i++) {
+        if(g->node_cost[0][i] > max_cost) {
+            max_cost = g->node_cost[0][i];
+        }
+    }
+    s.ring_size = (uint16_t)(max_cost + 1);
+
+    s.dist = malloc(node_count * sizeof(atomic_uint_least16_t));
+    s.ring = calloc(s.ring_size, sizeof(IdVec));
+    s.locals = calloc(num_threads, sizeof(ThreadLocal));
+    if(!s.dist || !s.ring || !s.locals) {
+        fprintf(stderr, "Allocation for parallel search failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < node_count; i++) {
+        atomic_init(&s.dist[i], DIST_INFINITY);
+    }
+    for(unsigned t = 0; t < num_threads; t++) {
+        s.locals[t].ring = calloc(s.ring_size, sizeof(IdVec));
+        if(!s.locals[t].ring) {
+            fprintf(stderr, "Allocation for parallel search failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s.frontier = (IdVec) {0};
+
+    // the start node is the only node of the first bucket
+    const uint32_t start = (uint32_t)g->p1.x * g->height + g->p1.y;
+    s.k = g->node_cost[g->p1.x][g->p1.y];
+    atomic_store(&s.dist[start], s.k);
+    idvec_push(&s.frontier, start);
+
+    if(num_threads == 1) { // no need for any synchronization
+        while(!s.done) {
+            process_slice(&s, 0);
+            advance(&s);
+        }
+    }
+    else {
+        pthread_barrier_init(&s.barrier, NULL, num_threads);
+        pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
+        WorkerArg* args = malloc(num_threads * sizeof(WorkerArg));
+        if(!threads || !args) {
+            fprintf(stderr, "Allocation for parallel search failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        for(unsigned t = 0; t < num_threads; t++) {
+            args[t] = (WorkerArg) {.state = &s, .thread_id = t};
+        }
+        for(unsigned t = 1; t < num_threads; t++) {
+            if(pthread_create(&threads[t], NULL, worker, &args[t]) != 0) {
+                fprintf(stderr, "Creating thread for parallel search failed.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        worker(&args[0]); // the calling thread takes part as thread 0
+        for(unsigned t = 1; t < num_threads; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_barrier_destroy(&s.barrier);
+        free(threads);
+        free(args);
+    }
+
+    for(unsigned t = 0; t < num_threads; t++) {
+        free(s.locals[t].same_bucket.ids);
+        for(uint16_t r = 0; r < s.ring_size; r++) {
+            free(s.locals[t].ring[r].ids);
+        }
+        free(s.locals[t].ring);
+    }
+    for(uint16_t r = 0; r < s.ring_size; r++) {
+        free(s.ring[r].ids);
+    }
+    free(s.frontier.ids);
+    free(s.locals);
+    free(s.ring);
+    free(s.dist);
+    return s.result;
+}
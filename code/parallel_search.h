@@ -0,0 +1,28 @@
+#ifndef _PARALLEL_SEARCH_H
+#define _PARALLEL_SEARCH_H
+
+
+/*
+ * Multi-threaded exact search for a single graph.
+ *
+ * Since the node costs are small integers, the minimal number of intersections can be found by
+ * delta-stepping with delta = 1: all nodes with the same distance k form a bucket, and moves into nodes
+ * with cost 0 stay in the current bucket. Each bucket is processed in level-synchronous phases, in which
+ * the current frontier is split between the threads. Distances are only ever lowered with an atomic
+ * compare and swap, so every node is relaxed to its final distance exactly once per bucket.
+ */
+
+
+
+#include <stdint.h>
+
+#include "graph.h"
+
+
+// Calculate the same result as a_star_cost, i.e. the minimal number of intersections of a path between
+// p1 and p2 (including start and end), or -1 if there is none, using num_threads threads (>= 1).
+int16_t parallel_search_cost(const Graph* const g, const unsigned num_threads);
+
+
+
+#endif
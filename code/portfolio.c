@@ -0,0 +1,274 @@
+#include "portfolio.h"
+#include "bucket_search.h"
+#include "instance_gen.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+#define CALIBRATION_MAGIC      "WIRASCAL"
+#define CALIBRATION_MAGIC_SIZE 8
+#define CALIBRATION_VERSION    3
+
+#define CALIBRATION_SEED        1006
+#define CALIBRATION_INSTANCES   1000
+#define CALIBRATION_NOISE       1.1      // engines within this factor of the fastest count as equally fast
+#define CALIBRATION_MIN_SAMPLES 4        // cells with fewer instances get the engine of their size bin
+
+
+
+static const char* const engine_names[ENGINE_COUNT] = {"astar", "bucket", "zero"};
+
+// upper limits of the bins, except for the last bin
+static const float density_limits[DENSITY_BINS - 1] = {0.05f, 0.15f, 0.4f};
+static const float distance_limits[DISTANCE_BINS - 1] = {0.1f, 0.3f};
+
+// index of the first limit that value is below, or count if there is none
+static size_t bin_of(const float value, const float* const limits, const size_t count)
+{
+    size_t bin = 0;
+    while(bin < count && value >= limits[bin]) {
+        bin++;
+    }
+    return bin;
+}
+
+// 2^8, 2^11, 2^14, 2^17 nodes
+static size_t size_bin(const size_t nodes)
+{
+    size_t bin = 0;
+    for(size_t limit = (size_t)1 << 8; bin < SIZE_BINS - 1 && nodes >= limit; limit <<= 3) {
+        bin++;
+    }
+    return bin;
+}
+
+
+
+bool search_engine_parse(const char* name, SearchEngine* engine)
+{
+    for(size_t i = 0; i < ENGINE_COUNT; i++) {
+        if(strcmp(name, engine_names[i]) == 0) {
+            *engine = (SearchEngine)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+const char* search_engine_name(const SearchEngine engine)
+{
+    assert(engine < ENGINE_COUNT);
+    return engine_names[engine];
+}
+
+
+
+int16_t portfolio_solve(const Graph* const g, HeuristicFunc h, const SearchEngine engine)
+{
+    switch(engine) {
+        case ENGINE_BUCKET:
+            return bucket_search_cost(g);
+        case ENGINE_ZERO_CHECK:
+            if(zero_cost_connected(g)) {
+                return 0;
+            }
+            return a_star_cost(g, h);
+        default:
+            return a_star_cost(g, h);
+    }
+}
+
+
+
+InstanceFeatures instance_features(const EndpointRepr* const er, const Graph* const g)
+{
+    size_t covered = 0;
+    for(int i = 0; i < er->m; i++) {
+        const Wire* const w = &er->wires[i];
+        covered += ((size_t)(uint32_t)(w->x2 - w->x1) + 1) * ((size_t)(uint32_t)(w->y2 - w->y1) + 1);
+    }
+    const size_t reduced_nodes = (size_t)er->width * (size_t)er->height;
+    const unsigned distance = (unsigned)abs_diff(g->p1.x, g->p2.x) + abs_diff(g->p1.y, g->p2.y);
+    return (InstanceFeatures) {.nodes = (size_t)g->width * g->height,
+                               .density = (float)covered / (float)reduced_nodes,
+                               .distance = (float)distance / (float)(g->width + g->height)};
+}
+
+
+
+SearchEngine calibration_select(const CalibrationTable* const table, const InstanceFeatures* const features)
+{
+    const size_t s = size_bin(features->nodes);
+    const size_t d = bin_of(features->density, density_limits, DENSITY_BINS - 1);
+    const size_t e = bin_of(features->distance, distance_limits, DISTANCE_BINS - 1);
+    return (SearchEngine)table->best[s][d][e];
+}
+
+
+
+// Time of a single search of engine on a graph freshly built from er, in nanoseconds. Repeating a search on
+// the same graph would measure warm caches, which favors the zero check with its A* fallback far more than
+// the searches of a run, where every engine only sees each graph once.
+static double time_engine(const EndpointRepr* const er, HeuristicFunc h, const SearchEngine engine)
+{
+    Graph* g = build_graph(er);
+    const double start = now_ns();
+    portfolio_solve(g, h, engine);
+    const double elapsed = now_ns() - start;
+    graph_free(g);
+    return elapsed;
+}
+
+// The engine to select for the total times of all engines on the samples instances of a cell, zero_cost of
+// which have a path of cost 0. The fastest engine wins, but differences within CALIBRATION_NOISE are only the
+// noise of the measurement, so those are decided by the order bucket, A*, zero check. The zero check is only
+// a candidate if almost all instances of the cell had cost 0: the share of cost 0 in a cell differs between
+// workloads, and every miss costs a search with A*.
+static SearchEngine choose_engine(const double times[ENGINE_COUNT], const uint32_t zero_cost, const uint32_t samples)
+{
+    static const SearchEngine preference[ENGINE_COUNT] = {ENGINE_BUCKET, ENGINE_A_STAR, ENGINE_ZERO_CHECK};
+    const size_t candidates = 16 * (uint64_t)zero_cost >= 15 * (uint64_t)samples ? ENGINE_COUNT : ENGINE_COUNT - 1;
+    double fastest = times[preference[0]];
+    for(size_t i = 1; i < candidates; i++) {
+        fastest = times[preference[i]] < fastest ? times[preference[i]] : fastest;
+    }
+    size_t i = 0;
+    while(times[preference[i]] > fastest * CALIBRATION_NOISE) {
+        i++;
+    }
+    return preference[i];
+}
+
+
+// Generate calibration instance number index: mostly random boards with sizes spread over several orders
+// of magnitude, a third of them with close endpoints, and some combs. The number of wires decides the size
+// after the reduction, so it is drawn from ranges that cover all size bins, with fewer of the slow large
+// boards.
+static void calibration_instance(EndpointRepr* const er, GenRng* rng, const int index)
+{
+    static const uint32_t max_wires[16] = {8, 8, 8, 8, 8, 8, 8, 8, 32, 32, 32, 32, 96, 96, 96, 240};
+    const int m = 1 + (int)gen_below(rng, max_wires[index % 16]);
+    const int32_t size = 2 + (int32_t)gen_below(rng, 1u << (1 + gen_below(rng, 20)));
+    if(index % 8 == 0) {
+        gen_comb_instance(er, rng, m, size > m + 2 ? size : m + 2);
+        return;
+    }
+    gen_instance(er, rng, m, size);
+    if(index % 3 == 0) { // close endpoints are rare otherwise
+        const uint32_t near = 1 + (uint32_t)size / 16;
+        er->p2x = er->p1x + (int32_t)gen_below(rng, near);
+        er->p2y = er->p1y + (int32_t)gen_below(rng, near);
+        er->p2x = er->p2x < size ? er->p2x : size - 1;
+        er->p2y = er->p2y < size ? er->p2y : size - 1;
+    }
+}
+
+
+void calibration_run(CalibrationTable* table, HeuristicFunc h)
+{
+    static double times[SIZE_BINS][DENSITY_BINS][DISTANCE_BINS][ENGINE_COUNT]; // total per cell and engine
+    static uint32_t zero_cost[SIZE_BINS][DENSITY_BINS][DISTANCE_BINS]; // instances with a path of cost 0
+    memset(times, 0, sizeof(times));
+    memset(zero_cost, 0, sizeof(zero_cost));
+    memset(table, 0, sizeof(CalibrationTable));
+    GenRng rng = {CALIBRATION_SEED};
+    for(int i = 0; i < CALIBRATION_INSTANCES; i++) {
+        EndpointRepr er;
+        calibration_instance(&er, &rng, i);
+        reduce(&er);
+        Graph* g = build_graph(&er);
+        const InstanceFeatures features = instance_features(&er, g);
+        const size_t s = size_bin(features.nodes);
+        const size_t d = bin_of(features.density, density_limits, DENSITY_BINS - 1);
+        const size_t e = bin_of(features.distance, distance_limits, DISTANCE_BINS - 1);
+        for(size_t k = 0; k < ENGINE_COUNT; k++) { // rotate the order, so no engine always runs first
+            const SearchEngine engine = (SearchEngine)(((size_t)i + k) % ENGINE_COUNT);
+            times[s][d][e][engine] += time_engine(&er, h, engine);
+        }
+        zero_cost[s][d][e] += zero_cost_connected(g);
+        table->samples[s][d][e]++;
+        graph_free(g);
+        free(er.wires);
+    }
+
+    for(size_t s = 0; s < SIZE_BINS; s++) {
+        double size_times[ENGINE_COUNT] = {0}; // for the cells with too few samples
+        uint32_t size_zero_cost = 0;
+        uint32_t size_samples = 0;
+        for(size_t d = 0; d < DENSITY_BINS; d++) {
+            for(size_t e = 0; e < DISTANCE_BINS; e++) {
+                for(size_t k = 0; k < ENGINE_COUNT; k++) {
+                    size_times[k] += times[s][d][e][k];
+                }
+                size_zero_cost += zero_cost[s][d][e];
+                size_samples += table->samples[s][d][e];
+            }
+        }
+        const SearchEngine size_best = choose_engine(size_times, size_zero_cost, size_samples);
+        for(size_t d = 0; d < DENSITY_BINS; d++) {
+            for(size_t e = 0; e < DISTANCE_BINS; e++) {
+                const uint32_t samples = table->samples[s][d][e];
+                table->best[s][d][e] = (uint8_t)(samples >= CALIBRATION_MIN_SAMPLES
+                                                     ? choose_engine(times[s][d][e], zero_cost[s][d][e], samples)
+                                                     : size_best);
+            }
+        }
+    }
+}
+
+
+
+// File format: magic, uint32 version, uint32 number of bins of each feature, then the best engines and
+// the numbers of samples of all cells, like in CalibrationTable
+bool calibration_load(CalibrationTable* table, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        return false;
+    }
+    char magic[CALIBRATION_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t bins[3];
+    CalibrationTable loaded;
+    bool ok = fread(magic, 1, CALIBRATION_MAGIC_SIZE, file) == CALIBRATION_MAGIC_SIZE &&
+              memcmp(magic, CALIBRATION_MAGIC, CALIBRATION_MAGIC_SIZE) == 0 &&
+              fread(&version, sizeof(version), 1, file) == 1 && version == CALIBRATION_VERSION &&
+              fread(bins, sizeof(uint32_t), 3, file) == 3 && bins[0] == SIZE_BINS && bins[1] == DENSITY_BINS &&
+              bins[2] == DISTANCE_BINS && fread(loaded.best, sizeof(loaded.best), 1, file) == 1 &&
+              fread(loaded.samples, sizeof(loaded.samples), 1, file) == 1;
+    fclose(file);
+    const uint8_t* const best = &loaded.best[0][0][0];
+    for(size_t i = 0; ok && i < SIZE_BINS * DENSITY_BINS * DISTANCE_BINS; i++) {
+        ok = best[i] < ENGINE_COUNT;
+    }
+    if(ok) {
+        *table = loaded;
+    }
+    return ok;
+}
+
+
+
+bool calibration_save(const CalibrationTable* const table, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    const uint32_t version = CALIBRATION_VERSION;
+    const uint32_t bins[3] = {SIZE_BINS, DENSITY_BINS, DISTANCE_BINS};
+    bool ok = fwrite(CALIBRATION_MAGIC, 1, CALIBRATION_MAGIC_SIZE, file) == CALIBRATION_MAGIC_SIZE &&
+              fwrite(&version, sizeof(version), 1, file) == 1 && fwrite(bins, sizeof(uint32_t), 3, file) == 3 &&
+              fwrite(table->best, sizeof(table->best), 1, file) == 1 &&
+              fwrite(table->samples, sizeof(table->samples), 1, file) == 1;
+    if(fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,85 @@
+#ifndef _PORTFOLIO_H
+#define _PORTFOLIO_H
+
+
+/*
+ * Search portfolio and automatic engine selection
+ *
+ * No single search is the fastest on every board: A* is guided well on sparse boards where the cheapest
+ * path is nearly straight, a comb of wires between the endpoints makes it expand most of the board in an
+ * order that the bucket search gets for free, and boards with a wire-free path are decided fastest by a
+ * flood of the nodes with cost 0. The features measured right after reduce and build_graph are cheap: the
+ * number of nodes, the wire density (the nodes covered by the reduced wires per node, counted in O(m)) and
+ * the distance of the endpoints relative to width + height. Each feature is put into a few bins, and a
+ * calibration table holds the engine for every combination of bins. The table is filled by a calibration
+ * run that times all engines on generated instances on the local machine, and can be saved and loaded
+ * again so that it only has to be measured once. Every cell gets the engine that was fastest on its
+ * instances, where times within 10% count as equal and are decided in the order bucket, A*, zero check.
+ * The zero check is only a candidate in the cells where at least 15 of 16 instances had a path of cost 0,
+ * because on all others its flood is wasted and its A* is slower than the bucket search. Cells with
+ * fewer than 4 instances get the engine of all instances of their size bin.
+ */
+
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+#include "a_star.h"
+
+
+
+typedef enum SearchEngine {
+    ENGINE_A_STAR,     // a_star_cost
+    ENGINE_BUCKET,     // bucket_search_cost [see bucket_search.h]
+    ENGINE_ZERO_CHECK, // zero_cost_connected, and a_star_cost if the minimal cost is not 0
+    ENGINE_COUNT
+} SearchEngine;
+
+typedef struct InstanceFeatures {
+    size_t nodes;   // number of nodes of the graph
+    float density;  // number of nodes covered by wires per node (wires sharing a node count twice)
+    float distance; // manhattan distance of the endpoints / (width + height)
+} InstanceFeatures;
+
+#define SIZE_BINS     5 // nodes < 2^8, 2^11, 2^14, 2^17, or more
+#define DENSITY_BINS  4 // density < 0.05, 0.15, 0.4, or more
+#define DISTANCE_BINS 3 // distance < 0.1, 0.3, or more
+
+typedef struct CalibrationTable {
+    uint8_t best[SIZE_BINS][DENSITY_BINS][DISTANCE_BINS];     // SearchEngine
+    uint32_t samples[SIZE_BINS][DENSITY_BINS][DISTANCE_BINS]; // number of calibration instances per cell
+} CalibrationTable;
+
+
+
+// Parse the name of an engine (astar, bucket or zero). Returns false if the name is unknown.
+bool search_engine_parse(const char* name, SearchEngine* engine);
+const char* search_engine_name(const SearchEngine engine);
+
+// Calculate the minimal cost of a path between p1 and p2 with engine. h is the heuristic of A*.
+int16_t portfolio_solve(const Graph* const g, HeuristicFunc h, const SearchEngine engine);
+
+// Measure the features of the reduced instance er and its graph g.
+InstanceFeatures instance_features(const EndpointRepr* const er, const Graph* const g);
+
+// the engine for the features according to table
+SearchEngine calibration_select(const CalibrationTable* const table, const InstanceFeatures* const features);
+
+// Fill table by timing all engines (A* with heuristic h) on generated instances. Takes less than a second
+// on a current machine.
+void calibration_run(CalibrationTable* table, HeuristicFunc h);
+
+// Load a calibration table file. Returns false if it does not exist or is not a valid calibration file.
+// Calibration files are written in the byte order of the machine and are not meant to be portable.
+bool calibration_load(CalibrationTable* table, const char* path);
+
+// Save table to a calibration file. Returns false if writing failed.
+bool calibration_save(const CalibrationTable* const table, const char* path);
+
+
+
+#endif
@@ -1,5 +1,9 @@
 /*
  * Array based heap implementation of a priority queue
+ *
+ * The indexed heap keeps the id of every pair in a parallel array, so the position map can be updated
+ * while the pairs move without calling id_of again. Its sifts are iterative and keep the moving pair out
+ * of the array until its final position is found.
  */
 
 
@@ -10,6 +14,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+#define PQ_NOT_QUEUED UINT32_MAX // position of an id that is not in the indexed heap
 
 
 
@@ -17,7 +27,14 @@ struct PQueue {
     KeyValPair* nodes;
     size_t n;
     size_t allocated_n;
+    size_t peak_n;
     PQKeyCompareFunc keycmp;
+    // only used by the indexed heap, NULL otherwise
+    uint32_t* ids; // ids[i] is the id of nodes[i]
+    uint32_t* pos; // pos[id] is the index of the pair with this id in nodes, or PQ_NOT_QUEUED
+    size_t capacity;
+    PQIdFunc id_of;
+    const void* id_context;
 };
 
 
@@ -38,6 +55,17 @@ static inline size_t _pq_rchild(size_t index)
     return 2 * index + 2;
 }
 
+// the same for the indexed heap, must not be called on the root node
+static inline size_t _pq_indexed_parent(size_t index)
+{
+    return (index - 1) / PQ_INDEXED_ARITY;
+}
+
+static inline size_t _pq_indexed_first_child(size_t index)
+{
+    return PQ_INDEXED_ARITY * index + 1;
+}
+
 
 
 static void _pq_incr_allocated_n(PQueue* q)
@@ -53,6 +81,14 @@ static void _pq_incr_allocated_n(PQueue* q)
         exit(EXIT_FAILURE);
     }
     q->nodes = new_ptr;
+    if(q->ids) {
+        uint32_t* new_ids = realloc(q->ids, new_n * sizeof(uint32_t));
+        if(!new_ids) {
+            fprintf(stderr, "pq: Reallocating the ids to increase the capacity to %lu failed.\n", (unsigned long)new_n);
+            exit(EXIT_FAILURE);
+        }
+        q->ids = new_ids;
+    }
     q->allocated_n = new_n;
 }
 
@@ -71,6 +107,14 @@ static void _pq_decr_allocated_n(PQueue* q)
         return;
     }
     q->nodes = new_ptr;
+    if(q->ids) {
+        uint32_t* new_ids = realloc(q->ids, new_n * sizeof(uint32_t));
+        if(!new_ids) { // nodes is already smaller, so the ids must not stay bigger than it
+            fprintf(stderr, "pq: Reallocating the ids to decrease the capacity failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        q->ids = new_ids;
+    }
     q->allocated_n = new_n;
 }
 
@@ -119,6 +163,60 @@ static void _pq_heapify_node(PQueue* q, size_t node)
 
 
 
+// Move the pair at index of the indexed heap up until its parent has greater priority.
+static void _pq_indexed_sift_up(PQueue* q, size_t index)
+{
+    const KeyValPair moving = q->nodes[index];
+    const uint32_t moving_id = q->ids[index];
+    while(index != 0) {
+        const size_t parent = _pq_indexed_parent(index);
+        if(!q->keycmp(moving.key, q->nodes[parent].key)) {
+            break;
+        }
+        q->nodes[index] = q->nodes[parent];
+        q->ids[index] = q->ids[parent];
+        q->pos[q->ids[index]] = (uint32_t)index;
+        index = parent;
+    }
+    q->nodes[index] = moving;
+    q->ids[index] = moving_id;
+    q->pos[moving_id] = (uint32_t)index;
+}
+
+
+
+// Move the pair at index of the indexed heap down until none of its children has greater priority.
+static void _pq_indexed_sift_down(PQueue* q, size_t index)
+{
+    const KeyValPair moving = q->nodes[index];
+    const uint32_t moving_id = q->ids[index];
+    while(true) {
+        const size_t first = _pq_indexed_first_child(index);
+        if(first >= q->n) { // if index is a leaf
+            break;
+        }
+        const size_t end = first + PQ_INDEXED_ARITY < q->n ? first + PQ_INDEXED_ARITY : q->n;
+        size_t best = first;
+        for(size_t child = first + 1; child < end; child++) {
+            if(q->keycmp(q->nodes[child].key, q->nodes[best].key)) {
+                best = child;
+            }
+        }
+        if(!q->keycmp(q->nodes[best].key, moving.key)) {
+            break;
+        }
+        q->nodes[index] = q->nodes[best];
+        q->ids[index] = q->ids[best];
+        q->pos[q->ids[index]] = (uint32_t)index;
+        index = best;
+    }
+    q->nodes[index] = moving;
+    q->ids[index] = moving_id;
+    q->pos[moving_id] = (uint32_t)index;
+}
+
+
+
 // Free any internal pointers belonging to the PQueue struct and q itself.
 // This does not free pointers that are still saved in the queue.
 PQueue* pq_new(PQKeyCompareFunc compare)
@@ -135,6 +233,34 @@ PQueue* pq_new(PQKeyCompareFunc compare)
     }
     q->allocated_n = PQ_INIT_SIZE;
     q->n = 0;
+    q->peak_n = 0;
+    q->ids = NULL;
+    q->pos = NULL;
+    q->capacity = 0;
+    q->id_of = NULL;
+    q->id_context = NULL;
+    return q;
+}
+
+
+
+PQueue* pq_new_indexed(PQKeyCompareFunc compare, const size_t capacity, PQIdFunc id_of, const void* context)
+{
+    assert(capacity <= UINT32_MAX);
+    PQueue* q = pq_new(compare);
+    if(!q) {
+        return NULL;
+    }
+    q->ids = malloc(PQ_INIT_SIZE * sizeof(uint32_t));
+    q->pos = malloc((capacity ? capacity : 1) * sizeof(uint32_t));
+    if(!q->ids || !q->pos) {
+        pq_free(q); // also frees ids and pos
+        return NULL;
+    }
+    memset(q->pos, 0xFF, capacity * sizeof(uint32_t)); // PQ_NOT_QUEUED
+    q->capacity = capacity;
+    q->id_of = id_of;
+    q->id_context = context;
     return q;
 }
 
@@ -144,6 +270,8 @@ void pq_free(PQueue* q)
 {
     free(q->nodes);
     q->nodes = NULL;
+    free(q->ids);
+    free(q->pos);
     free(q);
 }
 
@@ -156,13 +284,60 @@ bool pq_is_empty(const PQueue* q)
 
 
 
+size_t pq_size(const PQueue* q)
+{
+    return q->n;
+}
+
+
+
+size_t pq_peak_size(const PQueue* q)
+{
+    return q->peak_n;
+}
+
+
+
+static void _pq_indexed_insert(PQueue* q, const KeyValPair new)
+{
+    const size_t id = q->id_of(q->id_context, new);
+    assert(id < q->capacity);
+    const uint32_t index = q->pos[id];
+    if(index != PQ_NOT_QUEUED) { // decrease-key
+        if(q->keycmp(new.key, q->nodes[index].key)) {
+            q->nodes[index] = new;
+            _pq_indexed_sift_up(q, index);
+        }
+        return;
+    }
+    if(q->n == q->allocated_n) {
+        _pq_incr_allocated_n(q);
+    }
+    q->nodes[q->n] = new;
+    q->ids[q->n] = (uint32_t)id;
+    q->n++;
+    if(q->n > q->peak_n) {
+        q->peak_n = q->n;
+    }
+    _pq_indexed_sift_up(q, q->n - 1);
+}
+
+
+
 void pq_insert(PQueue* q, const KeyValPair new)
 {
+    if(q->ids) {
+        _pq_indexed_insert(q, new);
+        return;
+    }
     if(q->n == q->allocated_n) {
         _pq_incr_allocated_n(q);
     }
     size_t idx_new = q->n;
     q->n++;
+    if(q->n > q->peak_n) {
+        q->peak_n = q->n;
+    }
     q->nodes[idx_new] = new;
     while(idx_new != 0 && q->keycmp(new.key, q->nodes[_pq_parent(idx_new)].key)) {
         size_t idx_parent = _pq_parent(idx_new);
@@ -186,7 +361,15 @@ KeyValPair pq_pop(PQueue* q)
 {
     KeyValPair result = q->nodes[0];
     q->n--;
-    if(q->n != 0) {
+    if(q->ids) {
+        q->pos[q->ids[0]] = PQ_NOT_QUEUED;
+        if(q->n != 0) {
+            q->nodes[0] = q->nodes[q->n];
+            q->ids[0] = q->ids[q->n];
+            _pq_indexed_sift_down(q, 0);
+        }
+    }
+    else if(q->n != 0) {
         q->nodes[0] = q->nodes[q->n];
         _pq_heapify_node(q, 0);
     }
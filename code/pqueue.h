@@ -4,12 +4,19 @@
 
 /*
  * Array based heap implementation of a priority queue
+ *
+ * There are two backends behind the same interface. pq_new creates a binary heap, into which the same value
+ * can be inserted several times, e.g. once for every improvement of a node in a search, so the outdated
+ * entries have to be popped and skipped later. pq_new_indexed creates a PQ_INDEXED_ARITY-ary heap with a
+ * position map from the id of every value to its index in the heap. It holds at most one pair per id,
+ * and inserting a pair whose id is already in the queue lowers its key instead (decrease-key).
  */
 
 
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 
 #ifndef PQ_KEY_TYPE
@@ -26,6 +33,10 @@
 #define PQ_REALLOC_DIVISOR  2  // divide the size by x if space is no longer needed
 #define PQ_DEALLOCATE_LIMIT 4  // dealloc space if less than 1/x of the allocated space is needed
 
+#ifndef PQ_INDEXED_ARITY
+#define PQ_INDEXED_ARITY 4 // number of children of a node in the indexed heap
+#endif
+
 
 
 typedef PQ_KEY_TYPE pq_keytype;
@@ -39,6 +50,9 @@ typedef struct KeyValPair {
 
 typedef bool (*PQKeyCompareFunc)(const pq_keytype, const pq_keytype);
 
+// id of the value of pair for the indexed heap, context is the pointer given to pq_new_indexed
+typedef size_t (*PQIdFunc)(const void* context, const KeyValPair pair);
+
 typedef struct PQueue PQueue;
 
 
@@ -46,6 +60,10 @@ typedef struct PQueue PQueue;
 // compare(key1, key2) == true iff key1 has greater priority than key2, i.e. it will be popped sooner.
 PQueue* pq_new(PQKeyCompareFunc compare);
 
+// Same as pq_new, but create an indexed heap for values whose ids id_of(context, pair) are < capacity.
+// capacity must be <= UINT32_MAX.
+PQueue* pq_new_indexed(PQKeyCompareFunc compare, const size_t capacity, PQIdFunc id_of, const void* context);
+
 // Free any internal pointers belonging to the PQueue struct and q itself.
 // This does not free pointers that are still saved in the queue.
 void pq_free(PQueue* q);
@@ -53,7 +71,15 @@ void pq_free(PQueue* q);
 // Returns true iff q is empty.
 bool pq_is_empty(const PQueue* q);
 
+// Returns the number of KeyValPairs in q.
+size_t pq_size(const PQueue* q);
+
+// Returns the greatest number of KeyValPairs that were in q at the same time.
+size_t pq_peak_size(const PQueue* q);
+
 // inserts KeyValPair new into q
+// If q is indexed and already contains a pair with the same id, that pair is replaced by new iff new.key
+// has greater priority, else q is not changed.
 void pq_insert(PQueue* q, const KeyValPair new);
 
 // Get the KeyValPair with the greatest priority without removing it from q.
@@ -0,0 +1,317 @@
+#include "result_cache.h"
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+
+
+#define CACHE_MAGIC         "WIRASCAC"
+#define CACHE_MAGIC_SIZE    8
+#define CACHE_VERSION       1
+#define CACHE_INIT_CAPACITY 64 // must be a power of 2
+#define KEY_HEADER_SIZE     7  // width, height, p1x, p1y, p2x, p2y, m
+
+
+
+typedef struct CacheEntry {
+    uint64_t hash;
+    size_t n;      // 0 iff the slot is empty
+    int32_t* data;
+    int16_t result;
+} CacheEntry;
+
+struct ResultCache {
+    CacheEntry* entries;
+    size_t capacity; // always a power of 2
+    size_t count;
+    unsigned long hits;
+    unsigned long misses;
+};
+
+
+
+static inline uint64_t hash_values(const int32_t* data, const size_t n)
+{
+    return hash_bytes(HASH_INIT, data, n * sizeof(int32_t));
+}
+
+
+
+// Comparison function for qsort, lexicographic order of the coordinates
+static int compare_wires(const void* a, const void* b)
+{
+    const Wire* wa = a;
+    const Wire* wb = b;
+    if(wa->x1 != wb->x1) {
+        return (wa->x1 > wb->x1) - (wa->x1 < wb->x1);
+    }
+    if(wa->y1 != wb->y1) {
+        return (wa->y1 > wb->y1) - (wa->y1 < wb->y1);
+    }
+    if(wa->x2 != wb->x2) {
+        return (wa->x2 > wb->x2) - (wa->x2 < wb->x2);
+    }
+    return (wa->y2 > wb->y2) - (wa->y2 < wb->y2);
+}
+
+// a wire followed by its crossing weight in the extended key, 5 packed int32_t
+typedef struct WeightedWire {
+    Wire wire;
+    int32_t weight;
+} WeightedWire;
+
+// Comparison function for qsort, order of the wires and then of the weights
+static int compare_weighted_wires(const void* a, const void* b)
+{
+    const WeightedWire* wa = a;
+    const WeightedWire* wb = b;
+    const int by_wire = compare_wires(&wa->wire, &wb->wire);
+    if(by_wire != 0) {
+        return by_wire;
+    }
+    return (wa->weight > wb->weight) - (wa->weight < wb->weight);
+}
+
+
+
+CacheKey cache_key_make(const EndpointRepr* const er, const uint16_t bend_penalty)
+{
+    assert(er && er->m >= 0);
+    // keys of instances without weights and bend penalty stay the same as before they were introduced
+    const bool extended = er->weights || bend_penalty;
+    CacheKey key;
+    key.n = KEY_HEADER_SIZE + (extended ? 5 * (size_t)er->m + 1 : 4 * (size_t)er->m);
+    key.data = malloc(key.n * sizeof(int32_t));
+    if(!key.data) {
+        fprintf(stderr, "Allocating %lu bytes for cache key failed.\n", (unsigned long)(key.n * sizeof(int32_t)));
+        exit(EXIT_FAILURE);
+    }
+    key.data[0] = er->width;
+    key.data[1] = er->height;
+    // the cost of a path does not depend on its direction, so order the endpoints
+    const bool swap = er->p1x > er->p2x || (er->p1x == er->p2x && er->p1y > er->p2y);
+    key.data[2] = swap ? er->p2x : er->p1x;
+    key.data[3] = swap ? er->p2y : er->p1y;
+    key.data[4] = swap ? er->p1x : er->p2x;
+    key.data[5] = swap ? er->p1y : er->p2y;
+    key.data[6] = er->m;
+    if(extended) {
+        static_assert(sizeof(WeightedWire) == 5 * sizeof(int32_t), "WeightedWire must be 5 packed int32_t");
+        WeightedWire* wires = (void*)(key.data + KEY_HEADER_SIZE);
+        for(int i = 0; i < er->m; i++) {
+            wires[i] = (WeightedWire) {er->wires[i], er->weights ? er->weights[i] : 1};
+        }
+        qsort(wires, (size_t)er->m, sizeof(WeightedWire), compare_weighted_wires);
+        key.data[key.n - 1] = bend_penalty;
+    }
+    else {
+        Wire* wires = (void*)(key.data + KEY_HEADER_SIZE); // Wire is 4 packed int32_t
+        memcpy(wires, er->wires, (size_t)er->m * sizeof(Wire));
+        qsort(wires, (size_t)er->m, sizeof(Wire), compare_wires);
+    }
+    key.hash = hash_values(key.data, key.n);
+    return key;
+}
+
+
+
+void cache_key_free(CacheKey* key)
+{
+    free(key->data);
+    key->data = NULL;
+}
+
+
+
+ResultCache* result_cache_new(void)
+{
+    ResultCache* c = malloc(sizeof(ResultCache));
+    if(!c) {
+        fprintf(stderr, "Allocation for ResultCache failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    c->entries = calloc(CACHE_INIT_CAPACITY, sizeof(CacheEntry));
+    if(!c->entries) {
+        fprintf(stderr, "Allocation for ResultCache entries failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    c->capacity = CACHE_INIT_CAPACITY;
+    c->count = 0;
+    c->hits = 0;
+    c->misses = 0;
+    return c;
+}
+
+
+
+void result_cache_free(ResultCache* c)
+{
+    for(size_t i = 0; i < c->capacity; i++) {
+        free(c->entries[i].data);
+    }
+    free(c->entries);
+    free(c);
+}
+
+
+
+// Find the slot of key, or the empty slot where it would have to be inserted (linear probing).
+static CacheEntry* find_slot(const ResultCache* c, const uint64_t hash, const int32_t* data, const size_t n)
+{
+    size_t i = (size_t)hash & (c->capacity - 1);
+    while(true) {
+        CacheEntry* e = &c->entries[i];
+        if(e->n == 0 || (e->hash == hash && e->n == n && memcmp(e->data, data, n * sizeof(int32_t)) == 0)) {
+            return e;
+        }
+        i = (i + 1) & (c->capacity - 1);
+    }
+}
+
+
+
+static void grow(ResultCache* c)
+{
+    CacheEntry* old_entries = c->entries;
+    const size_t old_capacity = c->capacity;
+    c->capacity *= 2;
+    c->entries = calloc(c->capacity, sizeof(CacheEntry));
+    if(!c->entries) {
+        fprintf(stderr, "Allocation for ResultCache entries failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < old_capacity; i++) {
+        if(old_entries[i].n != 0) {
+            *find_slot(c, old_entries[i].hash, old_entries[i].data, old_entries[i].n) = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+
+
+bool result_cache_lookup(ResultCache* c, const CacheKey* const key, int16_t* result)
+{
+    const CacheEntry* e = find_slot(c, key->hash, key->data, key->n);
+    if(e->n == 0) {
+        c->misses++;
+        return false;
+    }
+    c->hits++;
+    *result = e->result;
+    return true;
+}
+
+
+
+// insert without copying, takes ownership of data
+static void insert_owned(ResultCache* c, const uint64_t hash, int32_t* data, const size_t n, const int16_t result)
+{
+    if(2 * (c->count + 1) > c->capacity) { // keep the load factor <= 1/2
+        grow(c);
+    }
+    CacheEntry* e = find_slot(c, hash, data, n);
+    if(e->n != 0) { // already in the cache
+        free(data);
+        return;
+    }
+    *e = (CacheEntry) {.hash = hash, .n = n, .data = data, .result = result};
+    c->count++;
+}
+
+
+
+void result_cache_insert(ResultCache* c, const CacheKey* const key, const int16_t result)
+{
+    int32_t* data = malloc(key->n * sizeof(int32_t));
+    if(!data) {
+        fprintf(stderr, "Allocation for ResultCache entry failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(data, key->data, key->n * sizeof(int32_t));
+    insert_owned(c, key->hash, data, key->n, result);
+}
+
+
+
+unsigned long result_cache_hits(const ResultCache* c)
+{
+    return c->hits;
+}
+
+unsigned long result_cache_misses(const ResultCache* c)
+{
+    return c->misses;
+}
+
+
+
+// File format: magic, uint32 version, uint64 number of entries, then for each entry
+// uint64 n, int32 result, int32 data[n]. The hashes are recomputed when loading.
+bool result_cache_load(ResultCache* c, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        return errno == ENOENT; // a missing file is an empty cache
+    }
+    char magic[CACHE_MAGIC_SIZE];
+    uint32_t version;
+    uint64_t count;
+    bool ok = fread(magic, 1, CACHE_MAGIC_SIZE, file) == CACHE_MAGIC_SIZE &&
+              memcmp(magic, CACHE_MAGIC, CACHE_MAGIC_SIZE) == 0 && fread(&version, sizeof(version), 1, file) == 1 &&
+              version == CACHE_VERSION && fread(&count, sizeof(count), 1, file) == 1;
+    for(uint64_t i = 0; ok && i < count; i++) {
+        uint64_t n;
+        int32_t result;
+        if(fread(&n, sizeof(n), 1, file) != 1 || fread(&result, sizeof(result), 1, file) != 1 || n < KEY_HEADER_SIZE ||
+           n > SIZE_MAX / sizeof(int32_t)) {
+            ok = false;
+            break;
+        }
+        int32_t* data = malloc((size_t)n * sizeof(int32_t));
+        if(!data) {
+            fprintf(stderr, "Allocation for ResultCache entry failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        if(fread(data, sizeof(int32_t), (size_t)n, file) != n) {
+            free(data);
+            ok = false;
+            break;
+        }
+        insert_owned(c, hash_values(data, (size_t)n), data, (size_t)n, (int16_t)result);
+    }
+    fclose(file);
+    return ok;
+}
+
+
+
+bool result_cache_save(const ResultCache* c, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    const uint32_t version = CACHE_VERSION;
+    const uint64_t count = c->count;
+    bool ok = fwrite(CACHE_MAGIC, 1, CACHE_MAGIC_SIZE, file) == CACHE_MAGIC_SIZE &&
+              fwrite(&version, sizeof(version), 1, file) == 1 && fwrite(&count, sizeof(count), 1, file) == 1;
+    for(size_t i = 0; ok && i < c->capacity; i++) {
+        const CacheEntry* e = &c->entries[i];
+        if(e->n == 0) {
+            continue;
+        }
+        const uint64_t n = e->n;
+        const int32_t result = e->result;
+        ok = fwrite(&n, sizeof(n), 1, file) == 1 && fwrite(&result, sizeof(result), 1, file) == 1 &&
+             fwrite(e->data, sizeof(int32_t), e->n, file) == e->n;
+    }
+    if(fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,65 @@
+#ifndef _RESULT_CACHE_H
+#define _RESULT_CACHE_H
+
+
+/*
+ * Content-addressed cache of results
+ *
+ * Many instances become identical after reduce, e.g. if all wires are shifted in space or the same board
+ * is given with different absolute coordinates. The cache maps the canonical form of a reduced
+ * EndpointRepr (sorted wires plus endpoints) to its result, so a hit skips building the graph and the
+ * search entirely. The cache can be saved to and loaded from a file to reuse it between runs.
+ */
+
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+
+
+
+// canonical form of a reduced instance and its hash
+typedef struct CacheKey {
+    uint64_t hash;
+    size_t n;      // number of values in data
+    int32_t* data; // width, height, endpoints (in canonical order), m, sorted wires
+                   // or, with weights or a bend penalty: m, sorted wires each followed by its weight, penalty
+} CacheKey;
+
+typedef struct ResultCache ResultCache;
+
+
+// Build the canonical key of the reduced instance er, solved with the given bend penalty [see bend_search.h].
+// Caller is responsible for freeing it with cache_key_free.
+CacheKey cache_key_make(const EndpointRepr* const er, const uint16_t bend_penalty);
+void cache_key_free(CacheKey* key);
+
+
+// Create an empty cache. Guaranteed to return a valid pointer.
+ResultCache* result_cache_new(void);
+void result_cache_free(ResultCache* c);
+
+// Returns true and writes the stored result to *result iff key is in the cache.
+// Counts a hit or a miss.
+bool result_cache_lookup(ResultCache* c, const CacheKey* const key, int16_t* result);
+
+// Store the result for key. key is copied. Does nothing if key is already in the cache.
+void result_cache_insert(ResultCache* c, const CacheKey* const key, const int16_t result);
+
+unsigned long result_cache_hits(const ResultCache* c);
+unsigned long result_cache_misses(const ResultCache* c);
+
+// Add all entries of the cache file at path to c. A file that does not exist counts as empty.
+// Returns false if the file exists but could not be read or is not a valid cache file.
+// Cache files are written in the byte order of the machine and are not meant to be portable.
+bool result_cache_load(ResultCache* c, const char* path);
+
+// Write all entries of c to the file at path. Returns false if writing failed.
+bool result_cache_save(const ResultCache* c, const char* path);
+
+
+
+#endif
@@ -0,0 +1,245 @@
+#include "steiner.h"
+#include "a_star.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+// path metrics are keys, node ids x * height + y are values
+#define PQ_KEY_TYPE PathMetric
+#define PQ_VAL_TYPE uint32_t
+#include "pqueue.h"
+
+
+
+#define NO_PRED 0 // predecessor direction of the nodes of the tree and of the nodes not reached yet
+
+static const PathMetric infinite_score = {UINT16_MAX, UINT16_MAX};
+
+
+typedef struct Step {
+    uint8_t neighbor_bit; // bit of the step in the neighbors bitmap
+    uint8_t back_bit;     // bit of the opposite step
+} Step;
+
+static const Step steps[4] = {{NEIGH_X_NEG, NEIGH_X_POS},
+                              {NEIGH_X_POS, NEIGH_X_NEG},
+                              {NEIGH_Y_NEG, NEIGH_Y_POS},
+                              {NEIGH_Y_POS, NEIGH_Y_NEG}};
+
+
+// state shared by all growth steps
+typedef struct Growth {
+    const Graph* g;
+    PQueue* queue;
+    PathMetric* scores; // cheapest path from the tree to each node, not including the cost of the tree node
+    uint8_t* pred;      // neighbor bit of the step to the predecessor of each node on that path, or NO_PRED
+    bool* pending;      // the terminals that are not connected yet
+    int pending_count;
+    SteinerTree* tree;
+    size_t allocated_segments;
+    const int32_t* x_coords; // maps from the reduced coordinates to the ones of the input
+    const int32_t* y_coords;
+} Growth;
+
+
+
+// id of the neighbor of node id in the direction of neighbor_bit
+static inline uint32_t step_id(const Growth* const s, const uint32_t id, const uint8_t neighbor_bit)
+{
+    switch(neighbor_bit) {
+        case NEIGH_X_POS:
+            return id + s->g->height;
+        case NEIGH_X_NEG:
+            return id - s->g->height;
+        case NEIGH_Y_POS:
+            return id + 1;
+        default:
+            return id - 1;
+    }
+}
+
+static inline Uint16Point id_point(const Growth* const s, const uint32_t id)
+{
+    return (Uint16Point) {(uint16_t)(id / s->g->height), (uint16_t)(id % s->g->height)};
+}
+
+
+
+// Make node id a source of the search, i.e. a node of the tree.
+static void add_to_tree(Growth* s, const uint32_t id)
+{
+    const Uint16Point p = id_point(s, id);
+    s->tree->tree_map[p.x][p.y] = true;
+    if(s->pending[id]) {
+        s->pending[id] = false;
+        s->pending_count--;
+    }
+    s->scores[id] = (PathMetric) {0, 0};
+    s->pred[id] = NO_PRED;
+    pq_insert(s->queue, (KeyValPair) {.key = s->scores[id], .val = id});
+}
+
+
+// Append the segment between the reduced nodes a and b, which are in the same row or column.
+static void add_segment(Growth* s, const Uint16Point a, const Uint16Point b)
+{
+    SteinerTree* const tree = s->tree;
+    if((size_t)tree->segment_count == s->allocated_segments) {
+        s->allocated_segments = s->allocated_segments ? 2 * s->allocated_segments : 16;
+        tree->segments = realloc(tree->segments, s->allocated_segments * sizeof(Wire));
+        if(!tree->segments) {
+            fprintf(stderr, "Allocation for tree segments failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    const bool ordered = a.x < b.x || a.y < b.y;
+    const Uint16Point lo = ordered ? a : b;
+    const Uint16Point hi = ordered ? b : a;
+    tree->segments[tree->segment_count++] =
+        (Wire) {s->x_coords[lo.x], s->y_coords[lo.y], s->x_coords[hi.x], s->y_coords[hi.y]};
+}
+
+
+
+// Continue the search until a pending terminal is popped with its final score. Returns its id, or
+// UINT32_MAX if the queue runs empty, i.e. no pending terminal can be reached anymore.
+static uint32_t search_next_terminal(Growth* s)
+{
+    const Graph* const g = s->g;
+    while(!pq_is_empty(s->queue)) {
+        const KeyValPair current = pq_pop(s->queue);
+        const uint32_t id = current.val;
+        if(cheaper_path(s->scores[id], current.key)) { // outdated entry
+            continue;
+        }
+        s->tree->expansions++;
+        if(s->pending[id]) {
+            return id; // it becomes a source when its branch is added, so it is expanded then
+        }
+        const Uint16Point p = id_point(s, id);
+        const uint8_t neighbors = g->neighbors[p.x][p.y];
+        for(size_t d = 0; d < 4; d++) {
+            if(!(neighbors & steps[d].neighbor_bit)) {
+                continue;
+            }
+            const uint32_t next = step_id(s, id, steps[d].neighbor_bit);
+            const Uint16Point q = id_point(s, next);
+            const PathMetric tentative = {(uint16_t)(current.key.intersections + g->node_cost[q.x][q.y]),
+                                          (uint16_t)(current.key.length + 1)};
+            if(cheaper_path(tentative, s->scores[next])) {
+                s->scores[next] = tentative;
+                s->pred[next] = steps[d].back_bit;
+                pq_insert(s->queue, (KeyValPair) {.key = tentative, .val = next});
+            }
+        }
+    }
+    return UINT32_MAX;
+}
+
+
+// Add the cheapest path from the tree to terminal id to the tree, as segments between its corners.
+static void add_branch(Growth* s, const uint32_t terminal)
+{
+    s->tree->cost += s->scores[terminal].intersections;
+    uint32_t id = terminal;
+    Uint16Point corner = id_point(s, id);
+    uint8_t direction = NO_PRED; // of the current straight part
+    while(!s->tree->tree_map[id_point(s, id).x][id_point(s, id).y]) {
+        const uint8_t back = s->pred[id];
+        assert(back != NO_PRED);
+        if(direction != NO_PRED && back != direction) {
+            add_segment(s, corner, id_point(s, id));
+            corner = id_point(s, id);
+        }
+        direction = back;
+        add_to_tree(s, id);
+        id = step_id(s, id, back);
+    }
+    add_segment(s, corner, id_point(s, id)); // up to the node of the tree where the branch starts
+}
+
+
+
+SteinerTree steiner_route(EndpointRepr* const er, const Terminal* const terminals, const int terminal_count)
+{
+    assert(er && er->m > 0 && terminals && terminal_count >= 1);
+    Terminal* reduced = malloc((size_t)terminal_count * sizeof(Terminal));
+    int32_t** xs = malloc((size_t)terminal_count * sizeof(int32_t*));
+    int32_t** ys = malloc((size_t)terminal_count * sizeof(int32_t*));
+    if(!reduced || !xs || !ys) {
+        fprintf(stderr, "Allocation for terminals failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(reduced, terminals, (size_t)terminal_count * sizeof(Terminal));
+    for(int i = 0; i < terminal_count; i++) {
+        xs[i] = &reduced[i].x;
+        ys[i] = &reduced[i].y;
+    }
+    er->p1x = er->p2x = terminals[0].x;
+    er->p1y = er->p2y = terminals[0].y;
+    int32_t* x_coords;
+    int32_t* y_coords;
+    reduce_with_points(er, xs, ys, (size_t)terminal_count, 1, &x_coords, &y_coords);
+    free(xs);
+    free(ys);
+
+    SteinerTree tree = {.graph = build_graph(er)};
+    const Graph* const g = tree.graph;
+    const size_t nodes = (size_t)g->width * g->height;
+    tree.tree_map = new_path_map(g->width, g->height);
+    Growth s = {.g = g, .queue = pq_new(cheaper_path), .scores = malloc(nodes * sizeof(PathMetric)),
+                .pred = calloc(nodes, sizeof(uint8_t)), .pending = calloc(nodes, sizeof(bool)), .tree = &tree,
+                .x_coords = x_coords, .y_coords = y_coords};
+    if(!tree.tree_map || !s.queue || !s.scores || !s.pred || !s.pending) {
+        fprintf(stderr, "Allocation for the search state of the tree failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < nodes; i++) {
+        s.scores[i] = infinite_score;
+    }
+    for(int i = 1; i < terminal_count; i++) {
+        const uint32_t id = (uint32_t)reduced[i].x * g->height + (uint32_t)reduced[i].y;
+        if(!s.pending[id]) {
+            s.pending[id] = true;
+            s.pending_count++;
+        }
+    }
+    const uint32_t root = (uint32_t)reduced[0].x * g->height + (uint32_t)reduced[0].y;
+    tree.cost = g->node_cost[reduced[0].x][reduced[0].y];
+    add_to_tree(&s, root);
+
+    while(s.pending_count > 0) {
+        const uint32_t terminal = search_next_terminal(&s);
+        if(terminal == UINT32_MAX) {
+            tree.cost = -1;
+            break;
+        }
+        add_branch(&s, terminal);
+    }
+
+    pq_free(s.queue);
+    free(s.scores);
+    free(s.pred);
+    free(s.pending);
+    free(x_coords);
+    free(y_coords);
+    free(reduced);
+    return tree;
+}
+
+
+
+void steiner_tree_free(SteinerTree* tree)
+{
+    free(tree->segments);
+    free_path_map(tree->tree_map);
+    graph_free(tree->graph);
+    tree->segments = NULL;
+    tree->tree_map = NULL;
+    tree->graph = NULL;
+}
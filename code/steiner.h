@@ -0,0 +1,55 @@
+#ifndef _STEINER_H
+#define _STEINER_H
+
+
+/*
+ * Multi-pin nets (rectilinear Steiner tree heuristic)
+ *
+ * Connects k terminals with a tree that has few intersections in total, where every node of the tree
+ * counts once. Starting with the first terminal, the tree is repeatedly grown by a cheapest path from any
+ * of its nodes to the nearest terminal that is not connected yet. The nodes of the tree are already paid
+ * for, so every growth step is a search from all nodes of the tree as sources with a score of 0.
+ * All steps share a single score table and queue. When a branch is added, its nodes become sources and are
+ * inserted into the queue, which still holds the frontier of the previous step, and the search continues:
+ * the scores of all other nodes are still costs of real paths from the tree, so they only have to be
+ * lowered where the new branch is closer. Each step thus only explores the region around the new branch
+ * again instead of the whole board, as k - 1 separate searches would.
+ * The terminals are included in the reduction, and the tree is translated back to straight segments in
+ * the coordinates of the input.
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "endpoint_repr.h"
+#include "graph.h"
+
+
+
+typedef struct Terminal {
+    int32_t x;
+    int32_t y;
+} Terminal;
+
+typedef struct SteinerTree {
+    long cost;                // sum of the node costs of all nodes of the tree, -1 if a terminal cannot be connected
+    int segment_count;
+    Wire* segments;           // the straight segments of the tree in the coordinates of the input
+    Graph* graph;             // the reduced graph
+    bool** tree_map;          // marks the nodes of the tree in graph [see new_path_map]
+    unsigned long expansions; // number of nodes expanded in all growth steps together
+} SteinerTree;
+
+
+
+// Connect the terminals (in the coordinates of the input) on the board of er. er must not have been
+// reduced yet, it is reduced in place, and its endpoints are set to the first terminal. terminal_count
+// must be >= 1. Caller is responsible for freeing the result with steiner_tree_free.
+SteinerTree steiner_route(EndpointRepr* const er, const Terminal* const terminals, const int terminal_count);
+void steiner_tree_free(SteinerTree* tree);
+
+
+
+#endif
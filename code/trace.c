@@ -0,0 +1,103 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+
+
+#define TRACE_BUFFER_EVENTS 4096 // size of the buffer of each thread
+
+
+
+typedef struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+    size_t n;
+    int thread; // -1 until the first event
+} TraceBuffer;
+
+
+// Read by every recording thread without the lock, written with it. The lock orders the writes of the
+// buffers of different threads.
+static _Atomic(FILE*) trace_file = NULL;
+static pthread_mutex_t trace_file_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint next_thread = 0;
+static _Thread_local TraceBuffer buffer = {.n = 0, .thread = -1};
+
+
+
+bool trace_open(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    TraceFileHeader header = {.version = TRACE_VERSION, .event_size = sizeof(TraceEvent)};
+    memcpy(header.magic, TRACE_MAGIC, TRACE_MAGIC_SIZE);
+    if(fwrite(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+    pthread_mutex_lock(&trace_file_lock);
+    atomic_store(&trace_file, file);
+    pthread_mutex_unlock(&trace_file_lock);
+    return true;
+}
+
+
+
+void trace_flush(void)
+{
+    if(buffer.n == 0) {
+        return;
+    }
+    pthread_mutex_lock(&trace_file_lock);
+    FILE* const file = atomic_load(&trace_file);
+    if(file && fwrite(buffer.events, sizeof(TraceEvent), buffer.n, file) != buffer.n) {
+        fprintf(stderr, "Writing the trace file failed, stop recording.\n");
+        atomic_store(&trace_file, NULL);
+        fclose(file);
+    }
+    pthread_mutex_unlock(&trace_file_lock);
+    buffer.n = 0;
+}
+
+
+
+void trace_close(void)
+{
+    trace_flush();
+    pthread_mutex_lock(&trace_file_lock);
+    FILE* const file = atomic_load(&trace_file);
+    atomic_store(&trace_file, NULL);
+    if(file && fclose(file) != 0) {
+        fprintf(stderr, "Closing the trace file failed.\n");
+    }
+    pthread_mutex_unlock(&trace_file_lock);
+}
+
+
+
+void trace_record(const uint8_t type, const uint16_t x, const uint16_t y, const uint16_t intersections,
+                  const uint16_t length, const uint32_t value)
+{
+    if(!atomic_load_explicit(&trace_file, memory_order_relaxed)) { // flushing checks it again with the lock
+        return;
+    }
+    if(buffer.thread < 0) {
+        buffer.thread = (int)atomic_fetch_add(&next_thread, 1);
+    }
+    buffer.events[buffer.n++] = (TraceEvent) {.type = type,
+                                              .thread = (uint8_t)buffer.thread,
+                                              .x = x,
+                                              .y = y,
+                                              .intersections = intersections,
+                                              .length = length,
+                                              .reserved = 0,
+                                              .value = value};
+    if(buffer.n == TRACE_BUFFER_EVENTS) {
+        trace_flush();
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+
+/*
+ * Search trace recorder
+ *
+ * Only compiled in if WA_TRACE is defined [see the trace target in the Makefile]. Otherwise the
+ * TRACE_* macros expand to nothing and none of the functions below exist.
+ *
+ * Every thread appends its events to its own linear buffer, which is written to the trace file whenever
+ * it is full, so recording an event is just a few stores. It is not a ring buffer: a ring would overwrite
+ * the oldest events, and a trace is only useful for the heatmaps if it is complete. The file starts with a TraceFileHeader, followed
+ * by TraceEvents in the byte order of the machine. The events of different threads can be told apart by
+ * their thread field; within a thread they are in order. trace_view turns a trace into heatmaps.
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+#define TRACE_MAGIC      "WIRASTRC"
+#define TRACE_MAGIC_SIZE 8
+#define TRACE_VERSION    1
+
+// event types
+#define TRACE_SEARCH 0 // start of a search: x = width, y = height of the graph, value = 0
+#define TRACE_POP    1 // node expanded with the key (f_score) it was popped with, value = queue size after the pop
+#define TRACE_STALE  2 // popped entry that is outdated, since the node was reached more cheaply after the insertion
+#define TRACE_RELAX  3 // g_score of a node lowered, key = new f_score, value = queue size after the insertion
+#define TRACE_DONE   4 // end of a search, intersections = result (0xFFFF if there is no path)
+
+typedef struct TraceFileHeader {
+    char magic[TRACE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t event_size; // sizeof(TraceEvent)
+} TraceFileHeader;
+
+typedef struct TraceEvent {
+    uint8_t type;
+    uint8_t thread; // number of the thread in the order of their first event, modulo 256
+    uint16_t x;
+    uint16_t y;
+    uint16_t intersections;
+    uint16_t length;
+    uint16_t reserved;
+    uint32_t value;
+} TraceEvent;
+
+
+
+#ifdef WA_TRACE
+
+// Start recording to the file at path. Returns false if it cannot be opened.
+bool trace_open(const char* path);
+
+// Flush the buffer of the calling thread. Every thread that recorded events has to call this (or
+// trace_close) before it ends, else its last events are lost.
+void trace_flush(void);
+
+// Flush the buffer of the calling thread and close the trace file.
+void trace_close(void);
+
+// Append an event to the buffer of the calling thread. Does nothing if no trace file is open.
+void trace_record(const uint8_t type, const uint16_t x, const uint16_t y, const uint16_t intersections,
+                  const uint16_t length, const uint32_t value);
+
+#define TRACE_EVENT(type, x, y, intersections, length, value) \
+    trace_record((type), (x), (y), (intersections), (length), (uint32_t)(value))
+
+#else
+
+#define TRACE_EVENT(type, x, y, intersections, length, value) ((void)0)
+
+#endif
+
+
+
+#endif
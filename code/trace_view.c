@@ -0,0 +1,373 @@
+/*
+ * Viewer for search traces [see trace.h]
+ *
+ * Prints a summary of every search in the trace and renders the order of the expansions as heatmaps,
+ * i.e. PPM images over the reduced grid. Each search is rendered as a number of frames, frame k showing
+ * the state after k / FRAMES of its pops: expanded nodes are colored from blue (expanded first) to red
+ * (expanded last), nodes that have been reached but not expanded yet are gray, and the points to connect
+ * are white. Nodes with stale pops are drawn brighter in the final frame.
+ *
+ * Usage: trace_view [-f FRAMES] [-s SCALE] [-i INDEX] TRACE_FILE OUTPUT_PREFIX
+ * The images are written to OUTPUT_PREFIX_<search>_<frame>.ppm. With -i, only search INDEX (counting
+ * from 0) is rendered.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "trace.h"
+#include "util.h"
+
+
+
+#define DEFAULT_FRAMES 8
+#define DEFAULT_SCALE  1
+#define MAX_THREADS    256 // the thread field of an event has 8 bits
+
+
+
+// node states while replaying a search
+#define NODE_UNSEEN   0
+#define NODE_REACHED  1
+#define NODE_EXPANDED 2
+
+
+typedef struct Search {
+    uint16_t width;
+    uint16_t height;
+    size_t* events; // indices of the events of this search in the trace
+    size_t n;
+    size_t allocated_n;
+    size_t pops; // including stale pops
+} Search;
+
+typedef struct ViewOptions {
+    unsigned long frames;
+    unsigned long scale;
+    unsigned long index;
+    bool index_given;
+} ViewOptions;
+
+
+
+// Read all events of a trace file. Returns NULL if it is not a valid trace file.
+static TraceEvent* read_trace(const char* path, size_t* count)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "Opening '%s' failed.\n", path);
+        return NULL;
+    }
+    TraceFileHeader header;
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TRACE_MAGIC, TRACE_MAGIC_SIZE) != 0 ||
+       header.version != TRACE_VERSION || header.event_size != sizeof(TraceEvent)) {
+        fprintf(stderr, "'%s' is not a trace file of this version.\n", path);
+        fclose(file);
+        return NULL;
+    }
+    size_t allocated_n = 1024;
+    size_t n = 0;
+    TraceEvent* events = malloc(allocated_n * sizeof(TraceEvent));
+    while(events) {
+        n += fread(events + n, sizeof(TraceEvent), allocated_n - n, file);
+        if(n < allocated_n) {
+            break;
+        }
+        allocated_n *= 2;
+        TraceEvent* new_events = realloc(events, allocated_n * sizeof(TraceEvent));
+        if(!new_events) {
+            free(events);
+        }
+        events = new_events;
+    }
+    if(!events) {
+        fprintf(stderr, "Allocation for trace events failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    *count = n;
+    return events;
+}
+
+
+
+static void search_add_event(Search* s, const size_t event)
+{
+    if(s->n == s->allocated_n) {
+        s->allocated_n = s->allocated_n ? 2 * s->allocated_n : 1024;
+        s->events = realloc(s->events, s->allocated_n * sizeof(size_t));
+        if(!s->events) {
+            fprintf(stderr, "Allocation for search events failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->events[s->n++] = event;
+}
+
+
+
+// Split the events into searches. The events of a thread belong to its last TRACE_SEARCH event.
+static Search* split_searches(const TraceEvent* events, const size_t count, size_t* search_count)
+{
+    size_t allocated_n = 16;
+    size_t n = 0;
+    Search* searches = malloc(allocated_n * sizeof(Search));
+    long current[MAX_THREADS]; // index of the current search of each thread, -1 if none
+    if(!searches) {
+        fprintf(stderr, "Allocation for searches failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int t = 0; t < MAX_THREADS; t++) {
+        current[t] = -1;
+    }
+    for(size_t i = 0; i < count; i++) {
+        const TraceEvent* e = &events[i];
+        if(e->type == TRACE_SEARCH) {
+            if(n == allocated_n) {
+                allocated_n *= 2;
+                searches = realloc(searches, allocated_n * sizeof(Search));
+                if(!searches) {
+                    fprintf(stderr, "Allocation for searches failed.\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            searches[n] = (Search) {.width = e->x, .height = e->y};
+            current[e->thread] = (long)n++;
+            continue;
+        }
+        if(current[e->thread] < 0) {
+            continue; // the start of this search was not recorded
+        }
+        Search* s = &searches[current[e->thread]];
+        search_add_event(s, i);
+        s->pops += e->type == TRACE_POP || e->type == TRACE_STALE;
+    }
+    *search_count = n;
+    return searches;
+}
+
+
+
+static void print_summary(const TraceEvent* events, const Search* s, const size_t index)
+{
+    size_t pops = 0, stale = 0, relaxations = 0;
+    uint32_t max_queue = 0;
+    long result = -2; // -2 if the end of the search was not recorded
+    for(size_t k = 0; k < s->n; k++) {
+        const TraceEvent* e = &events[s->events[k]];
+        pops += e->type == TRACE_POP;
+        stale += e->type == TRACE_STALE;
+        relaxations += e->type == TRACE_RELAX;
+        if(e->type != TRACE_DONE && e->value > max_queue) {
+            max_queue = e->value;
+        }
+        if(e->type == TRACE_DONE) {
+            result = e->intersections == UINT16_MAX ? -1 : e->intersections;
+        }
+    }
+    printf("search %zu: %ux%u, %zu pops, %zu stale pops, %zu relaxations, max queue size %lu, ", index,
+           (unsigned)s->width, (unsigned)s->height, pops, stale, relaxations, (unsigned long)max_queue);
+    if(result == -2) {
+        printf("incomplete\n");
+    }
+    else {
+        printf("result %ld\n", result);
+    }
+}
+
+
+
+// color ramp from blue over cyan, green and yellow to red, t in [0, 1]
+static void heat_color(const double t, uint8_t rgb[3])
+{
+    const double s = 4 * (t < 0 ? 0 : t > 1 ? 1 : t);
+    const int segment = s >= 4 ? 3 : (int)s;
+    const uint8_t f = (uint8_t)(255 * (s - segment));
+    const uint8_t ramp[4][3] = {{0, f, 255}, {0, 255, (uint8_t)(255 - f)}, {f, 255, 0}, {255, (uint8_t)(255 - f), 0}};
+    memcpy(rgb, ramp[segment], 3);
+}
+
+
+
+static bool write_frame(const char* path, const Search* s, const uint8_t* state, const uint32_t* order,
+                        const uint32_t* stale, const Uint16Point* endpoints, const size_t endpoint_count,
+                        const size_t pops, const unsigned long scale)
+{
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    const size_t width = s->width * scale;
+    const size_t height = s->height * scale;
+    fprintf(file, "P6\n%zu %zu\n255\n", width, height);
+    uint8_t* row = malloc(width * 3);
+    if(!row) {
+        fprintf(stderr, "Allocation for image row failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    bool ok = true;
+    for(size_t py = 0; ok && py < height; py++) {
+        const uint16_t y = (uint16_t)(s->height - 1 - py / scale); // y = 0 is at the bottom, like in print_graph
+        for(size_t px = 0; px < width; px++) {
+            const uint16_t x = (uint16_t)(px / scale);
+            const size_t id = (size_t)x * s->height + y;
+            uint8_t* rgb = row + 3 * px;
+            if(state[id] == NODE_EXPANDED) {
+                heat_color(pops > 1 ? (double)order[id] / (double)(pops - 1) : 0, rgb);
+                if(stale && stale[id]) {
+                    for(int c = 0; c < 3; c++) {
+                        rgb[c] = (uint8_t)(rgb[c] / 2 + 128);
+                    }
+                }
+            }
+            else {
+                const uint8_t gray = state[id] == NODE_REACHED ? 96 : 0;
+                rgb[0] = rgb[1] = rgb[2] = gray;
+            }
+            for(size_t k = 0; k < endpoint_count; k++) {
+                if(endpoints[k].x == x && endpoints[k].y == y) {
+                    rgb[0] = rgb[1] = rgb[2] = 255;
+                }
+            }
+        }
+        ok = fwrite(row, 3, width, file) == width;
+    }
+    free(row);
+    if(fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+
+
+// Replay a search and write its frames.
+static bool render_search(const TraceEvent* events, const Search* s, const size_t index, const char* prefix,
+                          const ViewOptions* const opts)
+{
+    const size_t node_count = (size_t)s->width * s->height;
+    uint8_t* state = calloc(node_count, sizeof(uint8_t));
+    uint32_t* order = calloc(node_count, sizeof(uint32_t));
+    uint32_t* stale = calloc(node_count, sizeof(uint32_t));
+    if(!state || !order || !stale) {
+        fprintf(stderr, "Allocation for rendering failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    Uint16Point endpoints[2];
+    size_t endpoint_count = 0;
+    size_t pops = 0;
+    unsigned long frame = 1;
+    bool ok = true;
+    for(size_t k = 0; ok && k <= s->n; k++) {
+        const TraceEvent* e = k < s->n ? &events[s->events[k]] : NULL;
+        // write all frames that are complete before this event
+        while(ok && frame <= opts->frames && (!e || pops >= (s->pops * frame + opts->frames - 1) / opts->frames)) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s_%03zu_%02lu.ppm", prefix, index, frame);
+            const bool last = frame == opts->frames;
+            ok = write_frame(path, s, state, order, last ? stale : NULL, endpoints, endpoint_count, s->pops,
+                             opts->scale);
+            if(!ok) {
+                fprintf(stderr, "Writing '%s' failed.\n", path);
+            }
+            frame++;
+        }
+        if(!e || e->x >= s->width || e->y >= s->height) {
+            continue;
+        }
+        const size_t id = (size_t)e->x * s->height + e->y;
+        switch(e->type) {
+            case TRACE_POP:
+            case TRACE_STALE:
+                if(pops == 0 && endpoint_count < 2) { // the first pop is the start
+                    endpoints[endpoint_count++] = (Uint16Point) {e->x, e->y};
+                }
+                if(state[id] != NODE_EXPANDED) {
+                    state[id] = NODE_EXPANDED;
+                    order[id] = (uint32_t)pops;
+                }
+                stale[id] += e->type == TRACE_STALE;
+                pops++;
+                break;
+            case TRACE_RELAX:
+                if(state[id] == NODE_UNSEEN) {
+                    state[id] = NODE_REACHED;
+                }
+                break;
+            case TRACE_DONE:
+                if(endpoint_count < 2) {
+                    endpoints[endpoint_count++] = (Uint16Point) {e->x, e->y};
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    free(state);
+    free(order);
+    free(stale);
+    return ok;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    ViewOptions opts = {.frames = DEFAULT_FRAMES, .scale = DEFAULT_SCALE, .index = 0, .index_given = false};
+    int c;
+    while((c = getopt(argc, argv, "f:s:i:")) != -1) {
+        switch(c) {
+            case 'f':
+                if(!parse_ulong_arg(optarg, &opts.frames) || opts.frames == 0 || opts.frames > 99) {
+                    fprintf(stderr, "Invalid number of frames `%s' (1 to 99).\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                if(!parse_ulong_arg(optarg, &opts.scale) || opts.scale == 0 || opts.scale > 64) {
+                    fprintf(stderr, "Invalid scale `%s' (1 to 64).\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'i':
+                if(!parse_ulong_arg(optarg, &opts.index)) {
+                    fprintf(stderr, "Invalid search index `%s'.\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                opts.index_given = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-f FRAMES] [-s SCALE] [-i INDEX] TRACE_FILE OUTPUT_PREFIX\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(argc - optind != 2) {
+        fprintf(stderr, "Usage: %s [-f FRAMES] [-s SCALE] [-i INDEX] TRACE_FILE OUTPUT_PREFIX\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t event_count;
+    TraceEvent* events = read_trace(argv[optind], &event_count);
+    if(!events) {
+        return EXIT_FAILURE;
+    }
+    size_t search_count;
+    Search* searches = split_searches(events, event_count, &search_count);
+    bool ok = true;
+    for(size_t i = 0; i < search_count; i++) {
+        print_summary(events, &searches[i], i);
+        if(ok && (!opts.index_given || opts.index == i)) {
+            ok = render_search(events, &searches[i], i, argv[optind + 1], &opts);
+        }
+        free(searches[i].events);
+    }
+    free(searches);
+    free(events);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
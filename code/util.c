@@ -0,0 +1,35 @@
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include "util.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+
+
+bool parse_ulong_arg(const char* arg, unsigned long* result)
+{
+    char* end;
+    if(!isdigit((unsigned char)arg[0])) {
+        return false;
+    }
+    *result = strtoul(arg, &end, 10);
+    return *end == '\0';
+}
+
+
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+
+
+PathMetric manhattan_distance(const Uint16Point p, const Uint16Point goal)
+{
+    return (PathMetric) {0, (uint16_t)(abs_diff(p.x, goal.x) + abs_diff(p.y, goal.y))};
+}
@@ -0,0 +1,59 @@
+#ifndef _UTIL_H
+#define _UTIL_H
+
+
+/*
+ * Small helpers shared by the library and the tools
+ */
+
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "a_star.h"
+
+
+
+// parse a non-negative integer option argument, return false if it is not a valid number
+bool parse_ulong_arg(const char* arg, unsigned long* result);
+
+
+// time of the monotonic clock in nanoseconds, for measuring wall-clock durations
+double now_ns(void);
+
+
+// calculate the absolute difference between two uint16 values
+static inline uint16_t abs_diff(const uint16_t a, const uint16_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+
+// calculate the manhattan distance between two Uint16Point as a heuristic for the length, without
+// any estimate for the intersections. The default heuristic of the searches.
+// manhattan_distance(p1, p2) = manhattan_distance(p2, p1) >= 0
+PathMetric manhattan_distance(const Uint16Point p, const Uint16Point goal);
+
+
+// Lexicographic comparison of path metrics, true iff a is a cheaper path than b. Also the comparison
+// function for the priority queues of the path searches.
+static inline bool cheaper_path(const PathMetric a, const PathMetric b)
+{
+    // This comparison can be efficiently implemented by interpreting the tuple as an unsigned integer,
+    // wherein the cost occupies the most significant bits and the distance occupies the least significant bits.
+    // When implementing, this version ran faster on my machine than a straightforward lexicographic comparison,
+    // but this may depend on architecture, compiler, optimization, etc.
+    uint32_t metric_a = a.length | ((uint32_t)a.intersections << (sizeof(a.length) * CHAR_BIT));
+    uint32_t metric_b = b.length | ((uint32_t)b.intersections << (sizeof(b.length) * CHAR_BIT));
+    // guaranteed to be true as long as nothing is changed, but this might catch a mistake if the types are changed
+    static_assert(sizeof(metric_a) >= sizeof(a.intersections) + sizeof(a.length),
+                  "size of metric insufficient to contain tuple of intersections and length");
+    return metric_a < metric_b;
+}
+
+
+
+#endif
@@ -12,38 +12,211 @@
 #include "endpoint_repr.h"
 #include "graph.h"
 #include "a_star.h"
-
-
-
-// parse args and write 0 or 1 to given pointers
-static bool parse_command_line_args(int argc, char** argv, int* gflag_ptr, int* hflag_ptr,
-                                    int* pflag_ptr, int* tflag_ptr)
+#include "bend_search.h"
+#include "implicit_graph.h"
+#include "landmarks.h"
+#include "multi_net.h"
+#include "steiner.h"
+#include "instance_file.h"
+#include "parallel_search.h"
+#include "portfolio.h"
+#include "result_cache.h"
+#include "trace.h"
+#include "util.h"
+
+
+
+#define DEFAULT_LANDMARK_COUNT 4 // number of landmarks if -l is given without -L
+#define BEND_PENALTY_MAX       1000
+
+// -T FILE only exists in builds with the trace recorder
+#ifdef WA_TRACE
+#define TRACE_OPTSTRING   "T:"
+#define TRACE_ARG_OPTIONS "T"
+#else
+#define TRACE_OPTSTRING   ""
+#define TRACE_ARG_OPTIONS ""
+#endif
+
+
+
+// command line options
+typedef struct Options {
+    bool graph;                // -g
+    bool help;                 // -h
+    bool path;                 // -p
+    bool time;                 // -t
+    const char* binary_input;  // -b FILE, solve the instances in a binary instance file instead of stdin
+    const char* binary_output; // -w FILE, convert the text input to a binary instance file
+    unsigned long first;       // -s N, index of the first instance to solve from the binary file
+    unsigned long count;       // -n N, maximum number of instances to solve from the binary file
+    bool count_given;
+    unsigned long threads;     // -j N, use the multi-threaded search with N threads, 0 if not set
+    bool compact;              // -c, use the compact search state
+    bool implicit;             // -i, search on an implicit graph instead of building the graph
+    bool cache;                // -r, reuse results of instances that are identical after the reduction
+    const char* cache_file;    // -R FILE, load the result cache from FILE and save it there again
+    unsigned long landmarks;   // -L K, use the landmark heuristic with K landmarks, 0 if not set
+    const char* landmark_file; // -l FILE, load the landmark tables from FILE and save new ones there
+    bool anytime;              // -a or -e, use the anytime search with the budget below
+    AnytimeBudget budget;      // -a MS, -e N
+    bool weighted;             // -W, every wire in the text input has a crossing weight
+    bool bends;                // -B N, search with a bend penalty
+    uint16_t bend_penalty;     // N of -B, 0 if not set
+    bool multi_net;            // -N ORDER, route several nets per board one after another
+    bool indexed_queue;        // -Q, use the indexed heap with decrease-key in the default search
+    bool steiner;              // -M, connect the K terminals of each board with a tree
+    bool portfolio;            // -E NAME or -C FILE, search with an engine of the portfolio
+    bool auto_engine;          // -E auto, select the engine of each instance by its features
+    SearchEngine engine;       // NAME of -E, unless it is auto
+    const char* table_file;    // -C FILE, load the calibration table of -E auto from FILE or save it there
+    NetOrder net_order;
+#ifdef WA_TRACE
+    const char* trace_file; // -T FILE, record a trace of the searches to FILE
+#endif
+} Options;
+
+// state that is kept between the instances
+typedef struct SolverState {
+    ResultCache* cache;            // NULL if the result cache is not used
+    LandmarkSet* landmarks;        // landmarks of the last board, NULL if not computed or loaded yet
+    CalibrationTable* calibration; // only used with -E auto
+} SolverState;
+
+
+
+// parse args and write them to opts
+static bool parse_command_line_args(int argc, char** argv, Options* opts)
 {
-    *gflag_ptr = 0;
-    *hflag_ptr = 0;
-    *pflag_ptr = 0;
-    *tflag_ptr = 0;
+    *opts = (Options) {0};
 
     opterr = 0;
 
     int c;
-    while((c = getopt(argc, argv, "ghpt")) != -1)
+    while((c = getopt(argc, argv, "cghiptWQMb:w:s:n:j:rR:L:l:a:e:B:N:E:C:" TRACE_OPTSTRING)) != -1)
         switch(c) {
+            case 'c':
+                opts->compact = true;
+                break;
             case 'g':
-                *gflag_ptr = 1;
+                opts->graph = true;
                 break;
             case 'h':
-                *hflag_ptr = 1;
+                opts->help = true;
+                break;
+            case 'i':
+                opts->implicit = true;
                 break;
             case 'p':
-                *pflag_ptr = 1;
-                *gflag_ptr = 1; // -p implies -g
+                opts->path = true;
+                opts->graph = true; // -p implies -g
                 break;
             case 't':
-                *tflag_ptr = 1;
+                opts->time = true;
+                break;
+            case 'W':
+                opts->weighted = true;
+                break;
+            case 'Q':
+                opts->indexed_queue = true;
+                break;
+            case 'M':
+                opts->steiner = true;
+                break;
+            case 'b':
+                opts->binary_input = optarg;
+                break;
+            case 'w':
+                opts->binary_output = optarg;
+                break;
+            case 's':
+                if(!parse_ulong_arg(optarg, &opts->first)) {
+                    fprintf(stderr, "Invalid instance index `%s'.\n", optarg);
+                    return false;
+                }
+                break;
+            case 'n':
+                if(!parse_ulong_arg(optarg, &opts->count)) {
+                    fprintf(stderr, "Invalid instance count `%s'.\n", optarg);
+                    return false;
+                }
+                opts->count_given = true;
+                break;
+            case 'r':
+                opts->cache = true;
+                break;
+            case 'R':
+                opts->cache_file = optarg;
+                opts->cache = true; // -R implies -r
+                break;
+            case 'L':
+                if(!parse_ulong_arg(optarg, &opts->landmarks) || opts->landmarks == 0 || opts->landmarks > 64) {
+                    fprintf(stderr, "Invalid number of landmarks `%s'.\n", optarg);
+                    return false;
+                }
                 break;
+            case 'l':
+                opts->landmark_file = optarg;
+                break;
+            case 'a':
+                if(!parse_ulong_arg(optarg, &opts->budget.max_ms) || opts->budget.max_ms == 0) {
+                    fprintf(stderr, "Invalid time budget `%s'.\n", optarg);
+                    return false;
+                }
+                opts->anytime = true;
+                break;
+            case 'e':
+                if(!parse_ulong_arg(optarg, &opts->budget.max_expansions) || opts->budget.max_expansions == 0) {
+                    fprintf(stderr, "Invalid expansion budget `%s'.\n", optarg);
+                    return false;
+                }
+                opts->anytime = true;
+                break;
+            case 'B': {
+                unsigned long penalty;
+                if(!parse_ulong_arg(optarg, &penalty) || penalty > BEND_PENALTY_MAX) {
+                    fprintf(stderr, "Invalid bend penalty `%s'.\n", optarg);
+                    return false;
+                }
+                opts->bend_penalty = (uint16_t)penalty;
+                opts->bends = true;
+                break;
+            }
+            case 'N':
+                if(!net_order_parse(optarg, &opts->net_order)) {
+                    fprintf(stderr, "Unknown net order `%s'.\n", optarg);
+                    return false;
+                }
+                opts->multi_net = true;
+                break;
+            case 'E':
+                if(strcmp(optarg, "auto") == 0) {
+                    opts->auto_engine = true;
+                }
+                else if(!search_engine_parse(optarg, &opts->engine)) {
+                    fprintf(stderr, "Unknown search engine `%s'.\n", optarg);
+                    return false;
+                }
+                opts->portfolio = true;
+                break;
+            case 'C':
+                opts->table_file = optarg;
+                break;
+            case 'j':
+                if(!parse_ulong_arg(optarg, &opts->threads) || opts->threads == 0 || opts->threads > 1024) {
+                    fprintf(stderr, "Invalid number of threads `%s'.\n", optarg);
+                    return false;
+                }
+                break;
+#ifdef WA_TRACE
+            case 'T':
+                opts->trace_file = optarg;
+                break;
+#endif
             case '?':
-                if(isprint(optopt))
+                if(strchr("bwsnjRLlaeBNEC" TRACE_ARG_OPTIONS, optopt))
+                    fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+                else if(isprint(optopt))
                     fprintf(stderr, "Unknown option `-%c'.\n", optopt);
                 else
                     fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
@@ -51,6 +224,69 @@ static bool parse_command_line_args(int argc, char** argv, int* gflag_ptr, int*
             default:
                 return false;
         }
+    if((opts->first != 0 || opts->count_given) && !opts->binary_input) {
+        fprintf(stderr, "Options -s and -n require -b.\n");
+        return false;
+    }
+    if(opts->threads && (opts->path || opts->compact)) {
+        fprintf(stderr, "Option -j cannot be combined with -p or -c.\n");
+        return false;
+    }
+    if(opts->landmark_file && !opts->landmarks) {
+        opts->landmarks = DEFAULT_LANDMARK_COUNT; // -l implies -L
+    }
+    if(opts->landmarks && (opts->implicit || opts->threads)) {
+        fprintf(stderr, "Options -L and -l cannot be combined with -i or -j.\n");
+        return false;
+    }
+    if(opts->anytime && (opts->implicit || opts->compact || opts->threads)) {
+        fprintf(stderr, "Options -a and -e cannot be combined with -i, -c or -j.\n");
+        return false;
+    }
+    if(opts->implicit && (opts->graph || opts->compact || opts->threads)) {
+        fprintf(stderr, "Option -i cannot be combined with -g, -p, -c or -j.\n");
+        return false;
+    }
+    if(opts->weighted && (opts->implicit || opts->binary_input || opts->binary_output)) {
+        fprintf(stderr, "Option -W cannot be combined with -i, -b or -w.\n");
+        return false;
+    }
+    if(opts->bends && (opts->implicit || opts->compact || opts->threads || opts->anytime)) {
+        fprintf(stderr, "Option -B cannot be combined with -i, -c, -j, -a or -e.\n");
+        return false;
+    }
+    if(opts->indexed_queue && (opts->implicit || opts->compact || opts->threads || opts->anytime || opts->bends)) {
+        fprintf(stderr, "Option -Q cannot be combined with -i, -c, -j, -a, -e or -B.\n");
+        return false;
+    }
+    if(opts->multi_net && (opts->implicit || opts->compact || opts->threads || opts->anytime || opts->bends ||
+                           opts->landmarks || opts->cache || opts->binary_input || opts->binary_output)) {
+        fprintf(stderr, "Option -N cannot be combined with -i, -c, -j, -a, -e, -B, -L, -l, -r, -R, -b or -w.\n");
+        return false;
+    }
+    if(opts->steiner && (opts->implicit || opts->compact || opts->threads || opts->anytime || opts->bends ||
+                         opts->landmarks || opts->cache || opts->binary_input || opts->binary_output || opts->multi_net ||
+                         opts->indexed_queue)) {
+        fprintf(stderr, "Option -M cannot be combined with -i, -c, -j, -a, -e, -B, -L, -l, -r, -R, -b, -w, -N "
+                        "or -Q.\n");
+        return false;
+    }
+    if(opts->table_file) {
+        if(opts->portfolio && !opts->auto_engine) {
+            fprintf(stderr, "Option -C requires -E auto.\n");
+            return false;
+        }
+        opts->portfolio = opts->auto_engine = true; // -C implies -E auto
+    }
+    if(opts->portfolio && (opts->implicit || opts->compact || opts->threads || opts->anytime || opts->bends ||
+                           opts->path || opts->landmarks || opts->multi_net || opts->steiner)) {
+        fprintf(stderr, "Options -E and -C cannot be combined with -i, -c, -j, -a, -e, -B, -p, -L, -l, -N or -M.\n");
+        return false;
+    }
+    if(opts->binary_input && opts->binary_output) {
+        fprintf(stderr, "Options -b and -w cannot be combined.\n");
+        return false;
+    }
     return true;
 }
 
@@ -59,207 +295,663 @@ static bool parse_command_line_args(int argc, char** argv, int* gflag_ptr, int*
 // Parse a problem instance read from stdin and write it into er.
 // Argument er must not be a nullpointer.
 // er->wires will be overwritten with NULL or a pointer to newly allocated memory, for which the
-// caller is responsible for freeing.
-static void parse_endpoint_repr(EndpointRepr* const er)
+// caller is responsible for freeing. If weighted is true, every wire is followed by its crossing weight,
+// and the same applies to er->weights, else er->weights is set to NULL.
+// If nets is not NULL, the first line also contains the number of nets, which is written to count,
+// and the third line contains their endpoints, which are written to newly allocated memory at *nets.
+// The endpoints of er are set to those of the first net.
+// Likewise, if terminals is not NULL, the third line contains the coordinates of count terminals.
+static void parse_endpoint_repr(EndpointRepr* const er, const bool weighted, Net** nets, Terminal** terminals,
+                                int* count)
 {
     assert(er);
+    er->weights = NULL;
     // read first line. Semantics: M S; Format ^[0-9]{1,2} [0-9]{1,9}$
-    scanf("%d %" SCNdFAST32, &(er->m), &(er->width));
+    scanf("%d %" SCNd32, &(er->m), &(er->width));
     er->height = er->width;
     if(er->width == 0) { // if the line just parsed marks the end of the input
         // ensure there is no random data there which might be falsely interpretet as a pointer
         er->wires = NULL;
         return;
     }
+    if(nets || terminals) { // With -N or -M: M S K
+        scanf("%d", count);
+        if(*count < 1) {
+            fprintf(stderr, "Invalid number of %s %d.\n", nets ? "nets" : "terminals", *count);
+            exit(EXIT_FAILURE);
+        }
+        if(nets) {
+            *nets = malloc((size_t)*count * sizeof(Net));
+        }
+        else {
+            *terminals = malloc((size_t)*count * sizeof(Terminal));
+        }
+        if(nets ? !*nets : !*terminals) {
+            fprintf(stderr, "Allocation for %s failed.\n", nets ? "nets" : "terminals");
+            exit(EXIT_FAILURE);
+        }
+    }
     er->wires = malloc((size_t)er->m * sizeof(Wire));
     if(!er->wires) {
         fprintf(stderr, "Allocating %lu bytes for EndpointRepr wires array failed.\n",
                 (unsigned long)((size_t)er->m * sizeof(Wire)));
         exit(EXIT_FAILURE);
     }
+    if(weighted) {
+        er->weights = malloc((size_t)er->m * sizeof(uint8_t));
+        if(!er->weights) {
+            fprintf(stderr, "Allocating %d bytes for EndpointRepr weights array failed.\n", er->m);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     // read second line. Semantics: (x_left y_bottom x_right y_bottom)*M; Format[0-9]{1,9} 4M times
+    // With -W: (x_left y_bottom x_right y_bottom weight)*M
     for(int i = 0; i < er->m; i++) {
-        int_fast32_t x1, y1, x2, y2;
-        scanf("%" SCNdFAST32 " %" SCNdFAST32 " %" SCNdFAST32 " %" SCNdFAST32, &x1, &y1, &x2, &y2);
+        int32_t x1, y1, x2, y2;
+        scanf("%" SCNd32 " %" SCNd32 " %" SCNd32 " %" SCNd32, &x1, &y1, &x2, &y2);
         er->wires[i].x1 = x1;
         er->wires[i].y1 = y1;
         er->wires[i].x2 = x2;
         er->wires[i].y2 = y2;
+        if(weighted) {
+            int weight = 0;
+            scanf("%d", &weight);
+            if(weight < 1 || weight > WIRE_WEIGHT_MAX) {
+                fprintf(stderr, "Invalid crossing weight %d, it must be between 1 and %d.\n", weight, WIRE_WEIGHT_MAX);
+                exit(EXIT_FAILURE);
+            }
+            er->weights[i] = (uint8_t)weight;
+        }
+    }
+
+    if(nets) {
+        // read third line. Semantics: (p1_x p1_y p2_x p2_y)*K
+        for(int i = 0; i < *count; i++) {
+            Net* const net = &(*nets)[i];
+            scanf("%" SCNd32 " %" SCNd32 " %" SCNd32 " %" SCNd32, &(net->p1x), &(net->p1y), &(net->p2x), &(net->p2y));
+        }
+        er->p1x = (*nets)[0].p1x;
+        er->p1y = (*nets)[0].p1y;
+        er->p2x = (*nets)[0].p2x;
+        er->p2y = (*nets)[0].p2y;
+        return;
+    }
+    if(terminals) {
+        // read third line. Semantics: (x y)*K
+        for(int i = 0; i < *count; i++) {
+            scanf("%" SCNd32 " %" SCNd32, &(*terminals)[i].x, &(*terminals)[i].y);
+        }
+        er->p1x = er->p2x = (*terminals)[0].x;
+        er->p1y = er->p2y = (*terminals)[0].y;
+        return;
     }
 
     // read third line. Semantics: p1_x p1_y p2_x p2_y; Format ^[0-9]{1,9} [0-9]{1,9} [0-9]{1,9} [0-9]{1,9}$
-    scanf("%" SCNdFAST32 " %" SCNdFAST32 " %" SCNdFAST32 " %" SCNdFAST32, &(er->p1x), &(er->p1y),
+    scanf("%" SCNd32 " %" SCNd32 " %" SCNd32 " %" SCNd32, &(er->p1x), &(er->p1y),
           &(er->p2x), &(er->p2y));
 }
 
 
 
-// Build a graph based on er
-// Caller is responsible for freeing returned graph with graph_free
-static Graph* build_graph(const EndpointRepr* const er)
+static void print_help(char* argv0)
+{
+    printf("Usage: %s [OPTIONS]\n", argv0);
+    printf("Read input from the 1006 ACM ICPC Problem 'Wiring Assistant' from stdin and solve it.\n\n");
+    printf("Options:\n");
+    printf("  -h\t(help)\tShow this help message and exit.\n");
+    printf("  -g\t(graph)\tPrint the graph after the reduction step.\n");
+    printf("  -p\t(path)\tMark the cheapest path in the printed graph. Implies -g.\n");
+    printf("  -t\t(time)\tMeasure and print the time to run each step.\n");
+    printf("  -c\t(compact)\tUse a compact search state with 2 bit predecessors and narrow scores.\n");
+    printf("  -i\t(implicit)\tDo not build the graph, compute it on demand from the wires. Cannot be\n"
+           "\t\t\tcombined with -g, -p, -c or -j.\n");
+    printf("  -Q\t(queue)\tUse an indexed 4-ary heap with decrease-key instead of the binary heap in the\n"
+           "\t\t\tsearch. Cannot be combined with -i, -c, -j, -a, -e or -B.\n");
+    printf("  -j N\t(jobs)\tSearch with N threads. Cannot be combined with -p or -c.\n");
+    printf("  -r\t(reuse)\tCache the results of instances that are identical after the reduction.\n");
+    printf("  -R FILE\t(reuse file)\tLike -r, but load the cache from FILE and save it there again. Implies -r.\n");
+    printf("  -L K\t(landmarks)\tGuide the search with exact distances from K landmarks (1 <= K <= 64).\n"
+           "\t\t\tThey only depend on the wires and are reused for following instances on the same\n"
+           "\t\t\tboard, whatever their endpoints. Cannot be combined with -i or -j.\n");
+    printf("  -l FILE\t(landmark file)\tLoad the landmarks from FILE if they match the board, else compute\n"
+           "\t\t\tthem and save them to FILE. Implies -L %d unless -L is given.\n", DEFAULT_LANDMARK_COUNT);
+    printf("  -a MS\t(anytime)\tSearch with an inflated heuristic that is lowered step by step, and stop after\n"
+           "\t\t\tMS milliseconds of wall-clock time per board with the best path found so far. Prints the\n"
+           "\t\t\tcost, a proven lower bound for the minimal cost and the bound for cost / minimal cost.\n"
+           "\t\t\tCannot be combined with -i, -c or -j.\n");
+    printf("  -e N\t(expansions)\tLike -a, but stop after N expanded nodes. Can be combined with -a.\n");
+    printf("  -W\t(weights)\tEvery wire in the input is followed by the cost of crossing it (1 to %d).\n"
+           "\t\t\tCannot be combined with -i, -b or -w.\n", WIRE_WEIGHT_MAX);
+    printf("  -B N\t(bends)\tAdd N (0 <= N <= %d) to the cost of the path for every bend. Cannot be combined\n"
+           "\t\t\twith -i, -c, -j, -a or -e.\n", BEND_PENALTY_MAX);
+#ifdef WA_TRACE
+    printf("  -T FILE\t(trace)\tRecord the pops, stale pops and relaxations of the default search to FILE\n"
+           "\t\t\t[see trace_view].\n");
+#endif
+    printf("  -E NAME\t(engine)\tSearch with the engine NAME of the portfolio: astar (the default search),\n"
+           "\t\t\tbucket (a 0-1 BFS with one bucket per cost instead of a heap), zero (a check for a path\n"
+           "\t\t\twithout intersections first, then astar) or auto (select one per instance by the size,\n"
+           "\t\t\twire density and endpoint distance of the reduced board, with a calibration table\n"
+           "\t\t\tmeasured on this machine at the start of every run, see -C). Cannot be combined with\n"
+           "\t\t\t-i, -c, -j, -a, -e, -B, -p, -L, -l, -N or -M.\n");
+    printf("  -C FILE\t(calibration)\tLoad the calibration table of -E auto from FILE, or measure it and save\n"
+           "\t\t\tit to FILE if FILE is not a valid calibration file. Implies -E auto.\n");
+    printf("  -N ORDER\t(nets)\tThe first line of each board also contains the number of nets K, and the last\n"
+           "\t\t\tline the endpoints of all K nets. Route them one after another, in the order of the\n"
+           "\t\t\tinput (ORDER = input) or shortest/longest first (short, long), every route becoming a\n"
+           "\t\t\twire for the following ones. Prints each route as its cost and its corners (-1 if the\n"
+           "\t\t\tnet is not routable), then the total cost of the routed nets and the number of the\n"
+           "\t\t\tother ones. Cannot be combined with -i, -c, -j, -a, -e, -B, -L, -l, -r, -R, -b or -w.\n");
+    printf("  -M\t(multi-pin)\tThe first line of each board also contains the number of terminals K, and the\n"
+           "\t\t\tlast line their coordinates. Connect all K terminals with a tree of few intersections,\n"
+           "\t\t\twhere every node of the tree counts once. Prints the cost of the tree followed by its\n"
+           "\t\t\tsegments (x1 y1 x2 y2 each). Cannot be combined with -i, -c, -j, -a, -e, -B, -L, -l, -r,\n"
+           "\t\t\t-R, -b, -w, -N or -Q.\n");
+    printf("  -w FILE\t(write)\tConvert the text input to the binary instance file FILE instead of solving it.\n");
+    printf("  -b FILE\t(binary)\tMemory map and solve the instances in the binary instance file FILE.\n");
+    printf("  -s N\t(start)\tStart at instance N (counting from 0) of the binary instance file. Requires -b.\n");
+    printf("  -n N\t(number)\tSolve at most N instances of the binary instance file. Requires -b.\n");
+    printf("\nAuthor\n  Written by Samuel Füßinger, 2024.\n  github.com/Samsu-F\n"); // Author and License ?
+}
+
+
+
+// Make sure state->landmarks belong to the board of er, which is not reduced yet, computing (and saving)
+// them if necessary.
+static void prepare_landmarks(const EndpointRepr* const er, const Options* const opts, SolverState* state)
+{
+    if(!state->landmarks || !landmarks_match(state->landmarks, er)) {
+        if(state->landmarks) {
+            landmarks_free(state->landmarks);
+        }
+        state->landmarks = landmarks_compute(er, (unsigned)opts->landmarks);
+        if(opts->landmark_file && !landmarks_save(state->landmarks, opts->landmark_file)) {
+            fprintf(stderr, "Saving landmarks to '%s' failed.\n", opts->landmark_file);
+        }
+    }
+}
+
+
+
+// Load the calibration table of -E auto from the file of -C, or measure it and save it to that file.
+// Without -C, the table is only measured and kept in memory.
+static void prepare_calibration(CalibrationTable* table, const Options* const opts)
+{
+    const char* path = opts->table_file;
+    if(path && calibration_load(table, path)) {
+        return;
+    }
+    clock_t time_0 = clock();
+    calibration_run(table, manhattan_distance);
+    if(opts->time) {
+        printf("calibration:    %7.3f ms\n", (float)(1000 * (clock() - time_0)) / CLOCKS_PER_SEC);
+    }
+    if(path && !calibration_save(table, path)) {
+        fprintf(stderr, "Saving calibration table to '%s' failed.\n", path);
+    }
+}
+
+
+
+// Print the result of the anytime search: cost, lower bound and suboptimality bound.
+static void print_anytime_result(const AnytimeResult* const result)
 {
-    Graph* g = graph_malloc(er->width, er->height);
-    g->width = (uint16_t)er->width;
-    g->height = (uint16_t)er->height;
-    // check if width and height are not too small for new data type
-    assert(((int_fast32_t)g->width == er->width) && ((int_fast32_t)g->height == er->height));
-    g->p1 = (Uint16Point) {(uint16_t)er->p1x, (uint16_t)er->p1y};
-    g->p2 = (Uint16Point) {(uint16_t)er->p2x, (uint16_t)er->p2y};
-    // by default nodes have a cost of 0
-    memset(g->node_cost[0], 0, g->width * g->height * sizeof(uint8_t));
-
-    uint8_t bitmask_all_neighbors = NEIGH_X_NEG | NEIGH_X_POS | NEIGH_Y_NEG | NEIGH_Y_POS;
-    memset(g->neighbors[0], bitmask_all_neighbors, g->width * g->height);
-    // now every node is marked as having all four neighbors. Remove neighbors where this does not apply
-    memset(g->neighbors[0], NEIGH_X_POS | NEIGH_Y_NEG | NEIGH_Y_POS, g->height);
-    memset(g->neighbors[er->width - 1], NEIGH_X_NEG | NEIGH_Y_NEG | NEIGH_Y_POS, g->height);
-    for(int_fast32_t x = 0; x < er->width; x++) {
-        g->neighbors[x][0] &= (uint8_t)~NEIGH_Y_NEG; // unset bit indicating neighbor in negative y direction
-        g->neighbors[x][er->height - 1] &= (uint8_t)~NEIGH_Y_POS;
-    }
-    // remove edges where existing wires are
-    for(int i = 0; i < er->m; i++) {             // for each wire in er
-        if(er->wires[i].y1 == er->wires[i].y2) { // horizontal wire in x direction
-            int_fast32_t x1 = er->wires[i].x1;
-            int_fast32_t x2 = er->wires[i].x2;
-            int_fast32_t y = er->wires[i].y1;
-            assert(x1 < x2);
-            g->neighbors[x1][y] &= (uint8_t)~NEIGH_X_POS; // no neighbor in positive x direction
-            g->node_cost[x1][y] += 1;                     // increase cost
-            for(int_fast32_t x = x1 + 1; x < x2; x++) {
-                g->neighbors[x][y] &= (uint8_t) ~(NEIGH_X_NEG | NEIGH_X_POS); // no neighbor in +- x direction
-                g->node_cost[x][y] += 1;                                      // increase cost
+    printf("%" PRId16 " %" PRId16 " %.2f\n", result->cost, result->lower_bound, result->bound);
+}
+
+
+
+// Solve a single problem instance and print the result. er will be reduced in place.
+// ms_parse_input is only used for printing the stopwatch times.
+static void solve_instance(EndpointRepr* const er, const Options* const opts, SolverState* state,
+                           const float ms_parse_input)
+{
+    ResultCache* cache = state->cache;
+    // Plan of attack:
+    //    1. Optionally prepare the landmarks, then reduction
+    //    2. Optionally look up the result in the cache
+    //    3. Build graph
+    //    4. Optionally activate the landmarks
+    //    5. Calculate cost of cheapest path using A* (or the engine selected with -E)
+    //    6. Optionally print graph and stopwatch times, print result
+    clock_t time_0 = clock();
+    int32_t* x_coords = NULL; // only used with -L, to map the lines of the graph to the landmark tables
+    int32_t* y_coords = NULL;
+    if(opts->landmarks) {
+        prepare_landmarks(er, opts, state);
+    }
+    clock_t time_1 = clock();
+
+    if(opts->landmarks) {
+        reduce_with_points(er, NULL, NULL, 0, 1, &x_coords, &y_coords);
+    }
+    else {
+        reduce(er);
+    }
+    clock_t time_2 = clock();
+
+    CacheKey cache_key = {0};
+    if(cache) {
+        cache_key = cache_key_make(er, opts->bend_penalty);
+        int16_t cached_result;
+        // if the graph is to be printed, it has to be built anyway
+        if(!opts->graph && result_cache_lookup(cache, &cache_key, &cached_result)) {
+            cache_key_free(&cache_key);
+            free(x_coords);
+            free(y_coords);
+            if(opts->time) {
+                float ms_simplify = (float)(1000 * (time_2 - time_1)) / CLOCKS_PER_SEC;
+                float ms_lookup = (float)(1000 * (clock() - time_2)) / CLOCKS_PER_SEC;
+                printf("parse input:    %7.3f ms\n"
+                       "reduce:         %7.3f ms\n"
+                       "cache hit:      %7.3f ms\n",
+                       ms_parse_input, ms_simplify, ms_lookup);
+            }
+            if(opts->anytime) { // cached results are always exact
+                print_anytime_result(&(AnytimeResult) {.cost = cached_result, .lower_bound = cached_result, .bound = 1.0f});
             }
-            g->neighbors[x2][y] &= (uint8_t)~NEIGH_X_NEG; // no neighbor in negative x direction
-            g->node_cost[x2][y] += 1;                     // increase cost
-        }
-        else { // vertical wire in y direction. Basically the same procedure as for horizontal wires
-            assert(er->wires[i].x1 == er->wires[i].x2);
-            int_fast32_t y1 = er->wires[i].y1;
-            int_fast32_t y2 = er->wires[i].y2;
-            int_fast32_t x = er->wires[i].x1;
-            assert(y1 < y2);
-            g->neighbors[x][y1] &= (uint8_t)~NEIGH_Y_POS;
-            g->node_cost[x][y1] += 1;
-            for(int_fast32_t y = y1 + 1; y < y2; y++) {
-                g->neighbors[x][y] &= (uint8_t) ~(NEIGH_Y_NEG | NEIGH_Y_POS);
-                g->node_cost[x][y] += 1;
+            else {
+                printf("%" PRId16 "\n", cached_result);
             }
-            g->neighbors[x][y2] &= (uint8_t)~NEIGH_Y_NEG;
-            g->node_cost[x][y2] += 1;
+            return;
+        }
+    }
+
+    Graph* graph = NULL;                   // not used with -i
+    ImplicitGraph* implicit_graph = NULL; // only used with -i
+    if(opts->implicit) {
+        implicit_graph = implicit_graph_new(er);
+    }
+    else {
+        graph = build_graph(er);
+    }
+    clock_t time_3 = clock();
+
+    HeuristicFunc heuristic = manhattan_distance;
+    if(opts->landmarks) {
+        landmarks_activate(state->landmarks, graph, x_coords, y_coords);
+        heuristic = landmark_heuristic;
+        free(x_coords);
+        free(y_coords);
+    }
+    clock_t time_3_landmarks = clock();
+
+    int16_t minimal_intersections;
+    AnytimeResult anytime_result = {0}; // only used with -a or -e
+    bool** path_map = NULL; // only used if the -p flag is set
+    SearchEngine engine = opts->engine; // only used with -E or -C
+    InstanceFeatures features = {0};    // only used with -E auto
+    if(opts->implicit) {
+        minimal_intersections = a_star_implicit_cost(implicit_graph, manhattan_distance);
+    }
+    else if(opts->bends) {
+        if(opts->path) {
+            path_map = new_path_map(graph->width, graph->height);
+            minimal_intersections = bend_search_path_map(graph, heuristic, opts->bend_penalty, path_map);
+        }
+        else {
+            minimal_intersections = bend_search_cost(graph, heuristic, opts->bend_penalty);
         }
     }
-    return g;
+    else if(opts->anytime) {
+        if(opts->path) {
+            path_map = new_path_map(graph->width, graph->height);
+        }
+        anytime_result = a_star_anytime(graph, heuristic, opts->budget, path_map);
+        minimal_intersections = anytime_result.cost;
+    }
+    else if(opts->path) {        // use a_star_path_map so that we can print the cheapest path later
+        path_map = new_path_map(graph->width, graph->height);
+        if(opts->compact) {
+            minimal_intersections = a_star_path_map_compact(graph, heuristic, path_map);
+        }
+        else {
+            minimal_intersections = a_star_path_map(graph, heuristic, path_map);
+        }
+    }
+    else if(opts->threads) {
+        minimal_intersections = parallel_search_cost(graph, (unsigned)opts->threads);
+    }
+    else if(opts->compact) {
+        minimal_intersections = a_star_cost_compact(graph, heuristic);
+    }
+    else if(opts->portfolio) {
+        if(opts->auto_engine) {
+            features = instance_features(er, graph);
+            engine = calibration_select(state->calibration, &features);
+        }
+        minimal_intersections = portfolio_solve(graph, heuristic, engine);
+    }
+    else { // use the marginally quicker version if the path will not be needed later
+        minimal_intersections = a_star_cost(graph, heuristic);
+    }
+    clock_t time_4 = clock();
+
+    if(opts->graph) {
+        printf("\n\n");
+        print_graph(graph, path_map);
+    }
+
+    if(opts->time) { // print stopwatch times
+        float ms_simplify = (float)(1000 * (time_2 - time_1)) / CLOCKS_PER_SEC;
+        float ms_build_gr = (float)(1000 * (time_3 - time_2)) / CLOCKS_PER_SEC;
+        float ms_landmarks = (float)(1000 * (time_1 - time_0 + time_3_landmarks - time_3)) / CLOCKS_PER_SEC;
+        float ms_min_inters = (float)(1000 * (time_4 - time_3_landmarks)) / CLOCKS_PER_SEC;
+        printf("parse input:    %7.3f ms\n"
+               "reduce:         %7.3f ms\n"
+               "build graph:    %7.3f ms\n",
+               ms_parse_input, ms_simplify, ms_build_gr);
+        if(opts->landmarks) {
+            printf("landmarks:      %7.3f ms\n", ms_landmarks);
+        }
+        if(opts->portfolio) {
+            printf("search:         %7.3f ms (%s)\n", ms_min_inters, search_engine_name(engine));
+            if(opts->auto_engine) {
+                printf("features:       %zu nodes, density %.3f, distance %.3f\n", features.nodes,
+                       (double)features.density, (double)features.distance);
+            }
+        }
+        else {
+            printf("A*:             %7.3f ms\n", ms_min_inters);
+        }
+        if(!opts->implicit && !opts->bends && !opts->anytime && !opts->threads && !opts->compact &&
+           !opts->portfolio) { // a_star() was used
+            printf("A* queue:       %zu entries at peak\n", a_star_peak_queue_size());
+        }
+        if(opts->anytime) {
+            printf("anytime:        %lu expansions, %u completed searches\n", anytime_result.expansions,
+                   anytime_result.iterations);
+        }
+    }
+
+    if(opts->anytime) {
+        print_anytime_result(&anytime_result);
+    }
+    else {
+        printf("%" PRId16 "\n", minimal_intersections); // print result
+    }
+
+    // results of the anytime search are only cached if they are exact
+    if(cache && opts->anytime && anytime_result.cost != anytime_result.lower_bound) {
+        cache_key_free(&cache_key);
+    }
+    else if(cache) {
+        result_cache_insert(cache, &cache_key, minimal_intersections);
+        cache_key_free(&cache_key);
+    }
+    if(opts->implicit) {
+        implicit_graph_free(implicit_graph);
+        implicit_graph = NULL;
+    }
+    else {
+        graph_free(graph);
+        graph = NULL;
+    }
+    if(opts->path) {
+        free_path_map(path_map);
+        path_map = NULL;
+    }
 }
 
 
 
-// calculate the absolute difference between two uint16 values
-static inline uint16_t abs_diff(const uint16_t a, const uint16_t b)
+// Print a route as its cost, followed by the coordinates of its endpoints and corners in the input.
+static void print_route(const Route* const route, const MultiNetResult* const result)
 {
-    return a > b ? a - b : b - a;
+    printf("%" PRId16, route->cost);
+    for(size_t i = 0; i < route->length; i++) {
+        const Uint16Point p = route->path[i];
+        if(i > 0 && i + 1 < route->length) { // skip the nodes in the middle of a straight segment
+            const Uint16Point prev = route->path[i - 1];
+            const Uint16Point next = route->path[i + 1];
+            if((prev.x == p.x && next.x == p.x) || (prev.y == p.y && next.y == p.y)) {
+                continue;
+            }
+        }
+        printf(" %" PRId32 " %" PRId32, result->x_coords[p.x], result->y_coords[p.y]);
+    }
+    printf("\n");
 }
 
-// calculate the manhattan distance between two Uint16Point
-// manhattan_distance(p1, p2) = manhattan_distance(p2, p1) >= 0
-static uint16_t manhattan_distance(const Uint16Point p, const Uint16Point goal)
+
+
+// Route the nets on the board er one after another, print every route and the total cost.
+// er will be reduced in place. ms_parse_input is only used for printing the stopwatch times.
+static void solve_multi_net(EndpointRepr* const er, const Net* const nets, const int net_count,
+                            const Options* const opts, const float ms_parse_input)
 {
-    return abs_diff(p.x, goal.x) + abs_diff(p.y, goal.y);
+    clock_t time_1 = clock();
+    MultiNetResult result = multi_net_route(er, nets, net_count, opts->net_order, manhattan_distance);
+    clock_t time_2 = clock();
+
+    if(opts->graph) { // the graph with all routes, marked if -p is given
+        bool** path_map = NULL;
+        if(opts->path) {
+            path_map = new_path_map(result.graph->width, result.graph->height);
+            for(int i = 0; i < net_count; i++) {
+                for(size_t j = 0; j < result.routes[i].length; j++) {
+                    path_map[result.routes[i].path[j].x][result.routes[i].path[j].y] = true;
+                }
+            }
+        }
+        printf("\n\n");
+        print_graph(result.graph, path_map);
+        if(path_map) {
+            free_path_map(path_map);
+        }
+    }
+    if(opts->time) {
+        float ms_route = (float)(1000 * (time_2 - time_1)) / CLOCKS_PER_SEC;
+        printf("parse input:    %7.3f ms\n"
+               "route nets:     %7.3f ms (%d nets on %" PRIu16 "x%" PRIu16 " nodes)\n",
+               ms_parse_input, ms_route, net_count, result.graph->width, result.graph->height);
+    }
+    for(int i = 0; i < net_count; i++) {
+        print_route(&result.routes[i], &result);
+    }
+    if(result.unrouted > 0) {
+        printf("total: %ld (%d of %d nets not routable)\n", result.total_cost, result.unrouted, net_count);
+    }
+    else {
+        printf("total: %ld\n", result.total_cost);
+    }
+    multi_net_result_free(&result);
 }
 
 
 
-static void print_help(char* argv0)
+// Connect the terminals on the board er with a tree, print its cost and its segments.
+// er will be reduced in place. ms_parse_input is only used for printing the stopwatch times.
+static void solve_steiner(EndpointRepr* const er, const Terminal* const terminals, const int terminal_count,
+                          const Options* const opts, const float ms_parse_input)
 {
-    printf("Usage: %s [OPTIONS]\n", argv0);
-    printf("Read input from the 1006 ACM ICPC Problem 'Wiring Assistant' from stdin and solve it.\n\n");
-    printf("Options:\n");
-    printf("  -h\t(help)\tShow this help message and exit.\n");
-    printf("  -g\t(graph)\tPrint the graph after the reduction step.\n");
-    printf("  -p\t(path)\tMark the cheapest path in the printed graph. Implies -g.\n");
-    printf("  -t\t(time)\tMeasure and print the time to run each step.\n");
-    printf("\nAuthor\n  Written by Samuel Füßinger, 2024.\n  github.com/Samsu-F\n"); // Author and License ?
+    clock_t time_1 = clock();
+    SteinerTree tree = steiner_route(er, terminals, terminal_count);
+    clock_t time_2 = clock();
+
+    if(opts->graph) {
+        printf("\n\n");
+        print_graph(tree.graph, opts->path ? tree.tree_map : NULL);
+    }
+    if(opts->time) {
+        float ms_tree = (float)(1000 * (time_2 - time_1)) / CLOCKS_PER_SEC;
+        printf("parse input:    %7.3f ms\n"
+               "steiner tree:   %7.3f ms (%d terminals on %" PRIu16 "x%" PRIu16 " nodes, %lu expansions)\n",
+               ms_parse_input, ms_tree, terminal_count, tree.graph->width, tree.graph->height, tree.expansions);
+    }
+    // the cost, followed by x1 y1 x2 y2 of every segment
+    printf("%ld", tree.cost);
+    if(tree.cost >= 0) {
+        for(int i = 0; i < tree.segment_count; i++) {
+            const Wire* const w = &tree.segments[i];
+            printf(" %" PRId32 " %" PRId32 " %" PRId32 " %" PRId32, w->x1, w->y1, w->x2, w->y2);
+        }
+    }
+    printf("\n");
+    steiner_tree_free(&tree);
 }
 
 
 
-int main(int argc, char** argv)
+// Convert all instances read from stdin to a binary instance file.
+static void convert_to_binary(const char* path)
 {
-    int gflag, hflag, pflag, tflag; // command line flags for printing the graph and time
-    if(!parse_command_line_args(argc, argv, &gflag, &hflag, &pflag, &tflag)) {
-        fprintf(stderr, "Parsing command line args failed.\n");
+    InstanceWriter* writer = instance_writer_open(path);
+    if(!writer) {
+        fprintf(stderr, "Opening '%s' for writing failed.\n", path);
         exit(EXIT_FAILURE);
     }
-    if(hflag) {         // help flag was set, so print help and exit
-        if(argv == 0) { // argc == 0 cannot happen with normal usage
-            exit(EXIT_FAILURE);
+    while(true) {
+        EndpointRepr endpoint_repr;
+        parse_endpoint_repr(&endpoint_repr, false, NULL, NULL, NULL);
+        if(endpoint_repr.width == 0) { // if end of input was reached
+            break;
         }
-        print_help(argv[0]);
-        exit(EXIT_SUCCESS);
+        instance_writer_add(writer, &endpoint_repr);
+        free(endpoint_repr.wires);
+        endpoint_repr.wires = NULL;
+    }
+    if(!instance_writer_close(writer)) {
+        fprintf(stderr, "Writing binary instance file '%s' failed.\n", path);
+        exit(EXIT_FAILURE);
     }
+}
+
+
+
+// Solve the selected range of instances of a binary instance file.
+static void solve_binary_file(const Options* const opts, SolverState* state)
+{
+    InstanceFile* file = instance_file_map(opts->binary_input);
+    if(!file) {
+        exit(EXIT_FAILURE);
+    }
+    const uint64_t n = instance_file_count(file);
+    const uint64_t first = opts->first < n ? opts->first : n;
+    uint64_t end = n;
+    if(opts->count_given && opts->count < n - first) {
+        end = first + opts->count;
+    }
+    for(uint64_t i = first; i < end; i++) {
+        clock_t time_0 = clock();
+        EndpointRepr endpoint_repr;
+        instance_file_get(file, i, &endpoint_repr); // no parsing, wires are used in place
+        clock_t time_1 = clock();
+        solve_instance(&endpoint_repr, opts, state, (float)(1000 * (time_1 - time_0)) / CLOCKS_PER_SEC);
+    }
+    instance_file_unmap(file);
+}
 
-    while(true) {
-        // Plan of attack:
-        //    1. Parse one problem instance from stdin
-        //    2. Reduction
-        //    3. Build graph
-        //    4. Calculate cost of cheapest path using A*
-        //    5. Optionally print graph and stopwatch times, print result
 
+
+// Solve all instances read from stdin.
+static void solve_text_input(const Options* const opts, SolverState* state)
+{
+    while(true) {
         clock_t time_0 = clock();
 
         EndpointRepr endpoint_repr;
-        parse_endpoint_repr(&endpoint_repr);
+        Net* nets = NULL;           // only used with -N
+        Terminal* terminals = NULL; // only used with -M
+        int count = 0;              // of nets or terminals
+        parse_endpoint_repr(&endpoint_repr, opts->weighted, opts->multi_net ? &nets : NULL,
+                            opts->steiner ? &terminals : NULL, &count);
         clock_t time_1 = clock();
 
         if(endpoint_repr.width == 0) { // if end of input was reached
-            return EXIT_SUCCESS;
+            return;
         }
 
-        reduce(&endpoint_repr);
-        clock_t time_2 = clock();
-
-        Graph* graph = build_graph(&endpoint_repr);
-        clock_t time_3 = clock();
-
-        int16_t minimal_intersections;
-        bool** path_map = NULL; // only used if the -p flag is set
-        if(pflag) {             // use a_star_path_map so that we can print the cheapest path later
-            path_map = new_path_map(graph->width, graph->height);
-            minimal_intersections = a_star_path_map(graph, manhattan_distance, path_map);
+        const float ms_parse_input = (float)(1000 * (time_1 - time_0)) / CLOCKS_PER_SEC;
+        if(opts->multi_net) {
+            solve_multi_net(&endpoint_repr, nets, count, opts, ms_parse_input);
+            free(nets);
+            nets = NULL;
         }
-        else { // use the marginally quicker version if the path will not be needed later
-            minimal_intersections = a_star_cost(graph, manhattan_distance);
+        else if(opts->steiner) {
+            solve_steiner(&endpoint_repr, terminals, count, opts, ms_parse_input);
+            free(terminals);
+            terminals = NULL;
         }
-        clock_t time_4 = clock();
+        else {
+            solve_instance(&endpoint_repr, opts, state, ms_parse_input);
+        }
+
+        free(endpoint_repr.wires);
+        endpoint_repr.wires = NULL;
+        free(endpoint_repr.weights);
+        endpoint_repr.weights = NULL;
+    }
+}
+
 
-        if(gflag) {
-            printf("\n\n");
-            print_graph(graph, path_map);
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if(!parse_command_line_args(argc, argv, &opts)) {
+        fprintf(stderr, "Parsing command line args failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    if(opts.help) {     // help flag was set, so print help and exit
+        if(argv == 0) { // argc == 0 cannot happen with normal usage
+            exit(EXIT_FAILURE);
         }
+        print_help(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+
+    a_star_use_indexed_queue(opts.indexed_queue);
 
-        if(tflag) { // print stopwatch times
-            float ms_parse_input = (float)(1000 * (time_1 - time_0)) / CLOCKS_PER_SEC;
-            float ms_simplify = (float)(1000 * (time_2 - time_1)) / CLOCKS_PER_SEC;
-            float ms_build_gr = (float)(1000 * (time_3 - time_2)) / CLOCKS_PER_SEC;
-            float ms_min_inters = (float)(1000 * (time_4 - time_3)) / CLOCKS_PER_SEC;
-            printf("parse input:    %7.3f ms\n"
-                   "reduce:         %7.3f ms\n"
-                   "build graph:    %7.3f ms\n"
-                   "A*:             %7.3f ms\n",
-                   ms_parse_input, ms_simplify, ms_build_gr, ms_min_inters);
+    if(opts.binary_output) {
+        convert_to_binary(opts.binary_output);
+        return EXIT_SUCCESS;
+    }
+    SolverState state = {.cache = NULL, .landmarks = NULL, .calibration = NULL};
+    if(opts.cache) {
+        state.cache = result_cache_new();
+        if(opts.cache_file && !result_cache_load(state.cache, opts.cache_file)) {
+            fprintf(stderr, "Loading result cache '%s' failed.\n", opts.cache_file);
+            exit(EXIT_FAILURE);
         }
+    }
+#ifdef WA_TRACE
+    if(opts.trace_file && !trace_open(opts.trace_file)) {
+        fprintf(stderr, "Opening trace file '%s' failed.\n", opts.trace_file);
+        exit(EXIT_FAILURE);
+    }
+#endif
+    if(opts.landmark_file) {
+        state.landmarks = landmarks_load(opts.landmark_file); // stays NULL if there is no valid file yet
+    }
+    CalibrationTable calibration;
+    if(opts.auto_engine) {
+        state.calibration = &calibration;
+        prepare_calibration(&calibration, &opts);
+    }
 
-        printf("%" PRId16 "\n", minimal_intersections); // print result
+    if(opts.binary_input) {
+        solve_binary_file(&opts, &state);
+    }
+    else {
+        solve_text_input(&opts, &state);
+    }
 
-        free(endpoint_repr.wires);
-        endpoint_repr.wires = NULL;
-        graph_free(graph);
-        graph = NULL;
-        if(pflag) {
-            free_path_map(path_map);
-            path_map = NULL;
+    if(state.cache) {
+        fprintf(stderr, "result cache: %lu hits, %lu misses\n", result_cache_hits(state.cache),
+                result_cache_misses(state.cache));
+        if(opts.cache_file && !result_cache_save(state.cache, opts.cache_file)) {
+            fprintf(stderr, "Saving result cache '%s' failed.\n", opts.cache_file);
+            exit(EXIT_FAILURE);
         }
+        result_cache_free(state.cache);
+    }
+    if(state.landmarks) {
+        landmarks_free(state.landmarks);
     }
+#ifdef WA_TRACE
+    trace_close();
+#endif
+    return EXIT_SUCCESS;
 }